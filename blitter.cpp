@@ -0,0 +1,62 @@
+/** Copyright (c) 2026, EtlamGit */
+
+#include <algorithm>
+#include <cstring>
+#include <QVarLengthArray>
+
+#include "blitter.h"
+
+void Blitter::blitScaled(QImage &dst, const quint32 *src, int size, int x, int y, int factor) {
+  const int w = size * factor;
+  // clip against destination image
+  const int x0 = std::max(0, -x), x1 = std::min(w, dst.width()  - x);
+  const int y0 = std::max(0, -y), y1 = std::min(w, dst.height() - y);
+  if ((x0 >= x1) || (y0 >= y1)) return;
+
+  uchar *bits = dst.bits();
+  const int bytesPerLine = dst.bytesPerLine();
+  QVarLengthArray<quint32, 16 * 128> row(w);
+
+  for (int sy = y0 / factor; sy * factor < y1; sy++) {
+    // replicate one source row
+    const quint32 *s = src + sy * size;
+    quint32 *r = row.data();
+    if (factor == 1) {
+      r = const_cast<quint32 *>(s);
+    } else {
+      for (int sx = 0; sx < size; sx++)
+        std::fill_n(r + sx * factor, factor, s[sx]);
+    }
+    // and copy it to all destination rows it covers
+    const int dy1 = std::min(y1, (sy + 1) * factor);
+    for (int dy = std::max(y0, sy * factor); dy < dy1; dy++) {
+      quint32 *d = reinterpret_cast<quint32 *>(bits + (y + dy) * bytesPerLine) + x;
+      memcpy(d + x0, r + x0, (x1 - x0) * sizeof(quint32));
+    }
+  }
+}
+
+void Blitter::blitHalved(QImage &dst, const quint32 *src, int size, int x, int y) {
+  const int half = size / 2;
+  QVarLengthArray<quint32, 8 * 8> reduced(half * half);
+  for (int ry = 0; ry < half; ry++) {
+    const quint32 *a = src + (2 * ry) * size;
+    const quint32 *b = a + size;
+    quint32 *d = reduced.data() + ry * half;
+    for (int rx = 0; rx < half; rx++)
+      d[rx] = average4(a[2 * rx], a[2 * rx + 1], b[2 * rx], b[2 * rx + 1]);
+  }
+  blitScaled(dst, reduced.constData(), half, x, y, 1);
+}
+
+QImage Blitter::halve(const QImage &src) {
+  QImage dst(src.width() / 2, src.height() / 2, src.format());
+  for (int y = 0; y < dst.height(); y++) {
+    const quint32 *a = reinterpret_cast<const quint32 *>(src.constScanLine(2 * y));
+    const quint32 *b = reinterpret_cast<const quint32 *>(src.constScanLine(2 * y + 1));
+    quint32 *d = reinterpret_cast<quint32 *>(dst.scanLine(y));
+    for (int x = 0; x < dst.width(); x++)
+      d[x] = average4(a[2 * x], a[2 * x + 1], b[2 * x], b[2 * x + 1]);
+  }
+  return dst;
+}
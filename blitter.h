@@ -0,0 +1,29 @@
+/** Copyright (c) 2026, EtlamGit */
+#ifndef BLITTER_H_
+#define BLITTER_H_
+
+#include <QImage>
+
+// Copies square images of 32 bit pixels straight into the scanlines of
+// a 32 bit QImage, without the overhead of a QPainter per Chunk.
+// The loops are kept simple so the compiler can vectorize them.
+class Blitter {
+ public:
+  // nearest neighbor magnification by an integer factor (1 = plain copy)
+  static void blitScaled(QImage &dst, const quint32 *src, int size, int x, int y, int factor);
+  // reduction by 2 with a box filter
+  static void blitHalved(QImage &dst, const quint32 *src, int size, int x, int y);
+  // reduction by 2 with a box filter (image with even size)
+  static QImage halve(const QImage &src);
+
+  // average of 4 pixels, channels are processed in two lanes of 16 bit each
+  static inline quint32 average4(quint32 p0, quint32 p1, quint32 p2, quint32 p3) {
+    quint32 rb = (p0 & 0x00ff00ff) + (p1 & 0x00ff00ff) +
+                 (p2 & 0x00ff00ff) + (p3 & 0x00ff00ff) + 0x00020002;
+    quint32 ag = ((p0 >> 8) & 0x00ff00ff) + ((p1 >> 8) & 0x00ff00ff) +
+                 ((p2 >> 8) & 0x00ff00ff) + ((p3 >> 8) & 0x00ff00ff) + 0x00020002;
+    return ((rb >> 2) & 0x00ff00ff) | (((ag >> 2) & 0x00ff00ff) << 8);
+  }
+};
+
+#endif  // BLITTER_H_
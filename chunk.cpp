@@ -4,6 +4,8 @@
 #include <typeinfo>     // typeid
 
 #include "chunk.h"
+#include "chunkcache.h"
+#include "chunkrenderer.h"
 #include "identifier/flatteningconverter.h"
 #include "identifier/blockidentifier.h"
 #include "identifier/biomeidentifier.h"
@@ -29,13 +31,16 @@ Chunk::Chunk()
   , lowest(INT_MAX)
   , loaded(false)
   , rendering(false)
+  , entitiesLoaded(false)
   , inhabitedTime(0)
   , lowestSection(0)
+  , hasSurface(false)
   , isChunkLocked(false)
 {}
 
 Chunk::~Chunk() {
   loaded = false;
+  releaseRenderVariants();
   for (auto sec : this->sections)
     if (sec)
       delete sec;
@@ -45,18 +50,38 @@ Chunk::~Chunk() {
 const unsigned int Chunk::air_hid = qHash(QString("minecraft:air"));
 
 
+// keep current base pass results for later reuse
+void Chunk::storeRenderVariant() {
+  renderVariants.store(*this, ChunkRenderer::overlayFlags, ChunkCache::Instance());
+}
+
+// reuse already rendered base pass results (overlays have to be applied again)
+bool Chunk::restoreRenderVariant(int depth, int flags) {
+  return renderVariants.restore(*this, depth, flags, ChunkRenderer::overlayFlags);
+}
+
+void Chunk::releaseRenderVariants() {
+  renderVariants.release(ChunkCache::Instance());
+}
+
+
 void Chunk::findHighestBlock()
 {
+  if (hasSurface) {
+    // stored Heightmap already knows the top of each column
+    highest = *std::max_element(surface, surface + 16*16);
+    return;
+  }
+
   // loop over all Sections in reverse order
   for (int i = this->sections.size() - 1; i >= 0; --i) {
     auto cs = this->sections.at(i);
     if (cs) {
       for (int j = 4095; j >= 0; j--) {
-        auto blockid = cs->blocks[j];
-        auto hid     = cs->blockPalette[blockid].hid;
+        auto hid = cs->getPaletteEntry(j).hid;
         if (hid != air_hid) {
           // Found the first non-air Block
-          highest = i * 16 + (j >> 8);
+          highest = (i + lowestSection) * 16 + (j >> 8);
           return;
         }
       }
@@ -68,6 +93,19 @@ const Chunk::EntityMap &Chunk::getEntityMap() const {
   return entities;
 }
 
+QList<QSharedPointer<GeneratedStructure>> Chunk::takeStructures() {
+  QList<QSharedPointer<GeneratedStructure>> taken;
+  taken.swap(structures);
+  return taken;
+}
+
+void Chunk::takeEntities(Chunk &other) {
+  entities.swap(other.entities);
+  isChunkLocked     = other.isChunkLocked;
+  chunkLockItemName = other.chunkLockItemName;
+  entitiesLoaded    = true;
+}
+
 //inline
 const ChunkSection *Chunk::getSectionByY(int y) const {
   if (y < -2048) return NULL;
@@ -156,6 +194,7 @@ int Chunk::getBiomeID(int x, int y, int z) const {
 void Chunk::load(const NBT &nbt) {
   renderedAt = INT_MIN;  // impossible.
   renderedFlags = 0;  // no flags
+  hasSurface = false;
   this->sections.clear();
 
   if (nbt.has("DataVersion"))
@@ -163,6 +202,10 @@ void Chunk::load(const NBT &nbt) {
   else
     this->version = 0;
 
+  // before 1.17 Entities are stored inline and parsed with the Chunk
+  if (version < 2681)
+    entitiesLoaded = true;
+
   if (nbt.has("Level")) {
     const Tag * level = nbt.at("Level");
     loadLevelTag(level);
@@ -237,6 +280,7 @@ void Chunk::loadLevelTag(const Tag * level) {
       }
 
       if (sectionContainsData) {
+        cs->updateMasks();
         this->setSectionByIdx(idx, cs);
         this->lowest = std::min(this->lowest, idx*16);
       } else {  // otherwise: delete cs
@@ -249,9 +293,7 @@ void Chunk::loadLevelTag(const Tag * level) {
   if (level->has("TileEntities")) {
     auto nbtListBE = level->at("TileEntities");
     auto belist    = GeneratedStructure::tryParseBlockEntites(nbtListBE);
-    for (auto it = belist.begin(); it != belist.end(); ++it) {
-      emit structureFound(*it);
-    }
+    structures.append(belist);
   }
 
   // parse Structures that start in this Chunk
@@ -259,9 +301,7 @@ void Chunk::loadLevelTag(const Tag * level) {
     if (level->has("Structures")) {
       auto nbtListStructures = level->at("Structures");
       auto structurelist     = GeneratedStructure::tryParseChunk(nbtListStructures);
-      for (auto it = structurelist.begin(); it != structurelist.end(); ++it) {
-        emit structureFound(*it);
-      }
+      structures.append(structurelist);
     }
   }
 
@@ -277,7 +317,8 @@ void Chunk::loadLevelTag(const Tag * level) {
   }
 
   // check for the highest block in this chunk
-  // todo: use highmap from stored NBT data
+  if (level->has("Status") && level->has("Heightmaps"))
+    loadHeightmaps(level->at("Status")->toString(), level->at("Heightmaps"), 0);
   findHighestBlock();
 
   loaded = true; // needs to be at the end!
@@ -316,6 +357,7 @@ void Chunk::loadCliffsCaves(const NBT &nbt) {
       ChunkSection *cs = new ChunkSection();
       if (loadSection2844(cs, section)) {
         // only if section contains usefull data, otherwise: delete cs
+        cs->updateMasks();
         this->setSectionByIdx(idx, cs);
         this->lowest = std::min(this->lowest, idx*16);
       } else {  // otherwise: delete cs
@@ -328,22 +370,21 @@ void Chunk::loadCliffsCaves(const NBT &nbt) {
   if (nbt.has("block_entities")) {
     auto nbtListBE = nbt.at("block_entities");
     auto belist    = GeneratedStructure::tryParseBlockEntites(nbtListBE);
-    for (auto it = belist.begin(); it != belist.end(); ++it) {
-      emit structureFound(*it);
-    }
+    structures.append(belist);
   }
 
   // parse Structures that start in this Chunk
   if (nbt.has("structures")) {
     auto nbtListStructures = nbt.at("structures");
     auto structurelist     = GeneratedStructure::tryParseChunk(nbtListStructures);
-    for (auto it = structurelist.begin(); it != structurelist.end(); ++it) {
-      emit structureFound(*it);
-    }
+    structures.append(structurelist);
   }
 
   // check for the highest block in this chunk
-  // todo: use highmap from stored NBT data
+  if (nbt.has("Status") && nbt.has("Heightmaps")) {
+    int minY = nbt.has("yPos") ? nbt.at("yPos")->toInt() * 16 : -64;
+    loadHeightmaps(nbt.at("Status")->toString(), nbt.at("Heightmaps"), minY);
+  }
   findHighestBlock();
 
   loaded = true; // needs to be at the end!
@@ -451,40 +492,52 @@ void Chunk::loadCheckEntityChunkLock(const Tag * entityNbt)
 // 2203 = 1.15.19w36a
 bool Chunk::loadSection1343(ChunkSection *cs, const Tag *section) {
   // copy raw data
-  quint8 blocks[4096];
-  quint8 data[2048];
+  quint8 blocks[4096] = {};
+  quint8 data[2048] = {};
+  quint8 light[2048] = {};
   safeMemCpy(blocks, section->at("Blocks")->toByteArray(), 4096);
   safeMemCpy(data,   section->at("Data")->toByteArray(),   2048);
-  safeMemCpy(cs->blockLight, section->at("BlockLight")->toByteArray(), 2048);
+  safeMemCpy(light,  section->at("BlockLight")->toByteArray(), 2048);
+  cs->setBlockLight(light);
 
   // convert old BlockID + data into virtual ID
+  quint16 vids[4096];
   for (int i = 0; i < 4096; i++) {
     int d = data[i>>1];         // get raw data (two nibbles)
     if (i & 1) d >>= 4;         // get one nibble of data
     // Shift enough so virtual IDs never overlap 0-4095 range
-    cs->blocks[i] = blocks[i] | ((d & 0x0f) << 12);
+    vids[i] = blocks[i] | ((d & 0x0f) << 12);
   }
 
   // parse optional "Add" part for higher block IDs in mod packs
   if (section->has("Add")) {
     auto raw = section->at("Add")->toByteArray();
-    for (int i = 0; i < 2048; i++) {
-      cs->blocks[i * 2] |= (raw[i] & 0xf) << 8;
-      cs->blocks[i * 2 + 1] |= (raw[i] & 0xf0) << 4;
+    int len = std::min<int>(2048, raw.size());
+    for (int i = 0; i < len; i++) {
+      vids[i * 2]     |= (raw[i] & 0xf) << 8;
+      vids[i * 2 + 1] |= (raw[i] & 0xf0) << 4;
     }
   }
 
-  // link to Converter palette
-  cs->blockPaletteLength = FlatteningConverter::Instance().paletteLength;
-  cs->blockPalette = FlatteningConverter::Instance().getPalette();
-  cs->blockPaletteIsShared = true;
-
-  // check if some Block is different to minecraft:air
-  bool sectionContainsData = false;
+  // build a Section palette from all used virtual IDs
+  PaletteEntry *converter = FlatteningConverter::Instance().getPalette();
+  QHash<quint16, quint16> vidIndex;
+  QVarLengthArray<quint32, 64> stateIds;
+  quint16 indices[4096];
   for (int i = 0; i < 4096; i++) {
-    sectionContainsData |= (cs->blocks[i] != 0);
+    auto it = vidIndex.constFind(vids[i]);
+    if (it == vidIndex.constEnd()) {
+      it = vidIndex.insert(vids[i], stateIds.size());
+      stateIds.append(BlockStateRegistry::Instance().getStateId(converter[vids[i]]));
+    }
+    indices[i] = it.value();
   }
-  return sectionContainsData;
+  cs->allocatePalette(stateIds.size());
+  std::copy(stateIds.constBegin(), stateIds.constEnd(), cs->blockPalette);
+  cs->setBlocks(indices);
+
+  // check if some Block is different to minecraft:air
+  return !(cs->isUniform() && (cs->getPaletteEntry(0).hid == air_hid));
 }
 
 
@@ -503,8 +556,8 @@ bool Chunk::loadSection1519(ChunkSection *cs, const Tag *section) {
     sectionContainsData = true;
   } else {
     // data tag is missing -> invent empty data
-    memset(cs->blocks, 0, sizeof(cs->blocks));
-    if ((cs->blockPaletteLength > 0) && (cs->blockPalette[0].name != "minecraft:air" )) {
+    cs->setBlocksUniform(0);
+    if ((cs->blockPaletteLength > 0) && (cs->getPaletteEntry(0).name != "minecraft:air" )) {
       sectionContainsData = true;
     }
   }
@@ -514,10 +567,10 @@ bool Chunk::loadSection1519(ChunkSection *cs, const Tag *section) {
 //    safeMemCpy(cs->skyLight, section->at("SkyLight")->toByteArray(), 2048);
 //  }
   if (section->has("BlockLight")) {
-    safeMemCpy(cs->blockLight, section->at("BlockLight")->toByteArray(), 2048);
+    quint8 light[2048] = {};
+    safeMemCpy(light, section->at("BlockLight")->toByteArray(), 2048);
+    cs->setBlockLight(light);
     sectionContainsData = true;
-  } else {
-    memset(cs->blockLight, 0, sizeof(cs->blockLight));
   }
 
   return sectionContainsData;
@@ -539,8 +592,8 @@ bool Chunk::loadSection2844(ChunkSection * cs, const Tag * section) {
     sectionContainsData = true;
   } else {
     // data tag is missing -> invent empty data
-    memset(cs->blocks, 0, sizeof(cs->blocks));
-    if ((cs->blockPaletteLength > 0) && (cs->blockPalette[0].name != "minecraft:air" )) {
+    cs->setBlocksUniform(0);
+    if ((cs->blockPaletteLength > 0) && (cs->getPaletteEntry(0).name != "minecraft:air" )) {
       sectionContainsData = true;
     }
   }
@@ -559,10 +612,10 @@ bool Chunk::loadSection2844(ChunkSection * cs, const Tag * section) {
 //    safeMemCpy(cs->skyLight, section->at("SkyLight")->toByteArray(), 2048);
 //  }
   if (section->has("BlockLight")) {
-    safeMemCpy(cs->blockLight, section->at("BlockLight")->toByteArray(), 2048);
+    quint8 light[2048] = {};
+    safeMemCpy(light, section->at("BlockLight")->toByteArray(), 2048);
+    cs->setBlockLight(light);
     sectionContainsData = true;
-  } else {
-    memset(cs->blockLight, 0, sizeof(cs->blockLight));
   }
 
   return sectionContainsData;
@@ -570,74 +623,48 @@ bool Chunk::loadSection2844(ChunkSection * cs, const Tag * section) {
 
 
 void Chunk::loadSection_decodeBlockPalette(ChunkSection * cs, const Tag * paletteTag) {
-  BlockIdentifier &bi = BlockIdentifier::Instance();
+  BlockStateRegistry &registry = BlockStateRegistry::Instance();
+
+  if (paletteTag->length() <= 0) {
+    loadSection_createDummyPalette(cs);
+    return;
+  }
 
-  cs->blockPaletteLength = paletteTag->length();
-  cs->blockPaletteIsShared = false;
-  cs->blockPalette = new PaletteEntry[cs->blockPaletteLength];
+  cs->allocatePalette(paletteTag->length());
   for (int j = 0; j < paletteTag->length(); j++) {
-    // get name and hash it to hid
-    cs->blockPalette[j].name = paletteTag->at(j)->at("Name")->toString();
-    uint hid  = qHash(cs->blockPalette[j].name);
-    // copy all other properties
-    if (paletteTag->at(j)->has("Properties"))
-    cs->blockPalette[j].properties = paletteTag->at(j)->at("Properties")->getData().toMap();
-
-    // check vor variants
-    BlockInfo const & block = bi.getBlockInfo(hid);
-    if (block.hasVariants()) {
-      // test all available properties
-      for (auto key : cs->blockPalette[j].properties.keys()) {
-        QString vname = cs->blockPalette[j].name + ":" + key + ":" + cs->blockPalette[j].properties[key].toString();
-        uint vhid = qHash(vname);
-        if (bi.hasBlockInfo(vhid))
-          hid = vhid; // use this vaiant instead
-      }
-      // test all possible combinations of 2 combined properties
-      if (cs->blockPalette[j].properties.keys().length() > 1) {
-        for (auto key1 : cs->blockPalette[j].properties.keys()) {
-          for (auto key2 : cs->blockPalette[j].properties.keys()) {
-            if (key1 == key2) continue;
-            QString vname = cs->blockPalette[j].name + ":" +
-                key1 + ":" + cs->blockPalette[j].properties[key1].toString() + " " +
-                key2 + ":" + cs->blockPalette[j].properties[key2].toString();
-            uint vhid = qHash(vname);
-            if (bi.hasBlockInfo(vhid))
-              hid = vhid; // use this vaiant instead
-          }
-        }
-      }
-    }
-    // store hash of found variant
-    cs->blockPalette[j].hid  = hid;
+    // known states are only looked up, new ones are decoded once
+    const Tag * entry = paletteTag->at(j);
+    const Tag * properties = entry->has("Properties") ? entry->at("Properties") : nullptr;
+    cs->blockPalette[j] = registry.getStateId(entry->at("Name")->toString(), properties);
   }
 }
 
 
 void Chunk::loadSection_createDummyPalette(ChunkSection *cs) {
   // create a dummy palette
-  cs->blockPalette = new PaletteEntry[1];
-  cs->blockPalette[0].name = "minecraft:air";
-  cs->blockPalette[0].hid  = air_hid;
-  cs->blockPaletteLength = 1;
+  cs->allocatePalette(1);
+  cs->blockPalette[0] = BlockStateRegistry::AIR;
 }
 
 
 void Chunk::loadSection_loadBlockStates(ChunkSection *cs, const Tag * blockStateTag) {
 
-  auto blockStates = blockStateTag->toLongArray();
+  const auto & blockStates = blockStateTag->toLongArray();
+  const int bsLen = static_cast<int>(blockStates.size());
   int bsCnt  = 0;  // counter for 64bit words
   int bitCnt = 0;  // counter for bits
 
+  quint16 blocks[4096] = {};  // decoded palette index for each Block
+
   if (this->version < 2529) {
     // "compact BlockStates" just the first time after "The Flattening"
-    for (int i = 0; i < 4096; i++) {
-      int bitSize = (blockStateTag->length())*64/4096;
-      int bitMask = (1 << bitSize)-1;
+    int bitSize = (blockStateTag->length())*64/4096;
+    int bitMask = (1 << bitSize)-1;
+    for (int i = 0; (i < 4096) && (bsCnt < bsLen); i++) {
       if (bitCnt+bitSize <= 64) {
         // bits fit into current word
         uint64_t blockState = blockStates[bsCnt];
-        cs->blocks[i] = (blockState >> bitCnt) & bitMask;
+        blocks[i] = (blockState >> bitCnt) & bitMask;
         bitCnt += bitSize;
         if (bitCnt == 64) {
           bitCnt = 0;
@@ -646,21 +673,21 @@ void Chunk::loadSection_loadBlockStates(ChunkSection *cs, const Tag * blockState
       } else {
         // bits are spread accross two words
         uint64_t blockState1 = blockStates[bsCnt++];
-        uint64_t blockState2 = blockStates[bsCnt];
+        uint64_t blockState2 = (bsCnt < bsLen) ? blockStates[bsCnt] : 0;
         uint32_t block = (blockState1 >> bitCnt) & bitMask;
         bitCnt += bitSize;
         bitCnt -= 64;
         block += (blockState2 << (bitSize - bitCnt)) & bitMask;
-        cs->blocks[i] = block;
+        blocks[i] = block;
       }
     }
   } else {
     // "optimized for loading" BlockStates since 1.16.20w17a
     int bitSize = std::max(4, int(ceil(log2(cs->blockPaletteLength))));
     int bitMask = (1 << bitSize)-1;
-    for (int i = 0; i < 4096; i++) {
+    for (int i = 0; (i < 4096) && (bsCnt < bsLen); i++) {
       uint64_t blockState = blockStates[bsCnt];
-      cs->blocks[i] = (blockState >> bitCnt) & bitMask;
+      blocks[i] = (blockState >> bitCnt) & bitMask;
       bitCnt += bitSize;
       if (bitCnt+bitSize > 64) {
         bsCnt++;
@@ -669,6 +696,7 @@ void Chunk::loadSection_loadBlockStates(ChunkSection *cs, const Tag * blockState
     }
   }
 
+  cs->setBlocks(blocks);
 }
 
 
@@ -678,60 +706,275 @@ bool Chunk::loadSection_decodeBiomePalette(ChunkSection * cs, const Tag * biomes
   if (biomesTag->has("palette")) {
     auto paletteTag = biomesTag->at("palette");
     int biomePaletteLength = paletteTag->length();
-    PaletteEntry* biomePalette = new PaletteEntry[biomePaletteLength];
+    if (biomePaletteLength <= 0) return false;
+    // only IDs are needed -> avoid heap allocation for the temporary palette
+    QVarLengthArray<quint16, 4*4*4> biomePalette(biomePaletteLength);
     for (int j = 0; j < biomePaletteLength; j++) {
-      biomePalette[j].name = paletteTag->at(j)->toString();
       // query BiomeIdentifer for that Biome
-      quint32 bID = bi.getBiomeByName(biomePalette[j].name).id;
-      // get name and hash it to hid
-      biomePalette[j].hid  = bID;
+      biomePalette[j] = bi.getBiomeByName(paletteTag->at(j)->toString()).id;
     }
 
     if (biomesTag->has("data")) {
-      auto biomeStates = biomesTag->at("data")->toLongArray();
+      const auto & biomeStates = biomesTag->at("data")->toLongArray();
+      const int bsLen = static_cast<int>(biomeStates.size());
       int bsCnt  = 0;  // counter for 64bit words
       int bitCnt = 0;  // counter for bits
 
       // "optimized for loading" Biome data
       int bitSize = std::max(1, int(ceil(log2(biomePaletteLength))));
       int bitMask = (1 << bitSize)-1;
-      int len = sizeof(cs->biomes)/sizeof(cs->biomes[0]);
-      for (int i = 0; i < len; i++) {
+      quint16 biomes[4*4*4];
+      std::fill_n(biomes, 4*4*4, biomePalette[0]);
+      for (int i = 0; (i < 4*4*4) && (bsCnt < bsLen); i++) {
         uint64_t biomeState = biomeStates[bsCnt];
-        cs->biomes[i] = biomePalette[(biomeState >> bitCnt) & bitMask].hid;
+        int idx = (biomeState >> bitCnt) & bitMask;
+        biomes[i] = (idx < biomePaletteLength) ? biomePalette[idx] : biomePalette[0];
         bitCnt += bitSize;
         if (bitCnt+bitSize > 64) {
           bsCnt++;
           bitCnt = 0;
         }
       }
+      cs->setBiomes(biomes);
 
     } else {
       // all Biome data is the same
-      std::fill_n(cs->biomes, sizeof(cs->biomes), biomePalette[0].hid);
+      cs->setBiomesUniform(biomePalette[0]);
     }
 
-    delete[] biomePalette;
-
     return true;
   } else return false;
 }
 
 
 
+// Heightmaps store for each column the number of Blocks above minY (9 bit each).
+// WORLD_SURFACE counts any non-air Block, so it is a safe start for rendering.
+// MOTION_BLOCKING and OCEAN_FLOOR skip Blocks we render (plants, fluids) and are not used.
+void Chunk::loadHeightmaps(const QString &status, const Tag * heightmapsTag, int minY) {
+  hasSurface = false;
+
+  // only finished Chunks have reliable Heightmaps
+  if ((status != "full") && (status != "minecraft:full") &&
+      (status != "fullchunk") && (status != "postprocessed"))
+    return;
+  if (!heightmapsTag->has("WORLD_SURFACE"))
+    return;
+
+  const auto & heights = heightmapsTag->at("WORLD_SURFACE")->toLongArray();
+  // before 1.16.20w17a values are spread across two words
+  const bool    spanning = (this->version < 2529);
+  // entry size depends on the height of the dimension (9 bit up to 511 Blocks),
+  // derive it from the array length
+  int bitSize = 0;
+  for (int bits = 1; bits <= 32; bits++) {
+    const int perLong = 64 / bits;
+    const size_t expected = spanning ? (256 * bits + 63) / 64 : (256 + perLong - 1) / perLong;
+    if (expected == heights.size()) {
+      if (bitSize != 0)
+        return;  // ambiguous length (e.g. 11 or 12 bit), columns have to be scanned
+      bitSize = bits;
+    }
+  }
+  if (bitSize == 0)
+    return;
+  const quint64 bitMask  = (quint64(1) << bitSize) - 1;
+
+  int bitCnt = 0;
+  size_t hCnt = 0;
+  for (int i = 0; i < 16*16; i++) {
+    if (!spanning && (bitCnt + bitSize > 64)) {
+      hCnt++;
+      bitCnt = 0;
+    }
+    quint64 value = quint64(heights[hCnt]) >> bitCnt;
+    if (bitCnt + bitSize > 64)
+      value |= quint64(heights[hCnt + 1]) << (64 - bitCnt);
+    bitCnt += bitSize;
+    if (bitCnt >= 64) {
+      hCnt++;
+      bitCnt -= 64;
+    }
+    // stored value is one above the highest Block
+    surface[i] = minY + int(value & bitMask) - 1;
+  }
+  hasSurface = true;
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // ChunkSection
 
 ChunkSection::ChunkSection()
   : blockPalette(NULL)
   , blockPaletteLength(0)
-  , blockPaletteIsShared(false)  // only the "old" converted format is using one shared palette
+  , blockBits(0)
+  , blockUniform(0)
+  , blocks(nullptr)
+  , biomeUniform(0)
+  , biomes(nullptr)
+  , blockLight(nullptr)
+  , maskUniform(0)
+  , masks(nullptr)
 {}
 
 ChunkSection::~ChunkSection() {
-  if (!(blockPaletteIsShared) && (blockPaletteLength > 0)) {
-    delete[] blockPalette;
+  releasePalette();
+  releaseStorage();
+}
+
+void ChunkSection::releaseStorage() {
+  StoragePool::release(blocks, (16*16*16 * blockBits) / 8);
+  StoragePool::release(reinterpret_cast<quint8 *>(biomes), 4*4*4 * sizeof(quint16));
+  StoragePool::release(blockLight, 16*16*16/2);
+  StoragePool::release(reinterpret_cast<quint8 *>(masks.loadAcquire()), mskCount * 16*16 * sizeof(quint16));
+  blockBits  = 0;
+  blocks     = nullptr;
+  biomes     = nullptr;
+  blockLight = nullptr;
+  masks.storeRelease(nullptr);
+}
+
+void ChunkSection::setBlocks(const quint16 *indices) {
+  StoragePool::release(blocks, (16*16*16 * blockBits) / 8);
+  blocks = nullptr;
+
+  // find the smallest representation that can hold all indices
+  quint16 maxIndex = 0;
+  bool    uniform  = true;
+  for (int i = 0; i < 16*16*16; i++) {
+    maxIndex = std::max(maxIndex, indices[i]);
+    uniform &= (indices[i] == indices[0]);
+  }
+
+  if (uniform) {
+    blockBits    = 0;
+    blockUniform = indices[0];
+  } else if (maxIndex < 16) {
+    blockBits = 4;
+    blocks = StoragePool::allocate(16*16*16/2);
+    for (int i = 0; i < 16*16*16/2; i++)
+      blocks[i] = quint8(indices[2*i] | (indices[2*i+1] << 4));
+  } else if (maxIndex < 256) {
+    blockBits = 8;
+    blocks = StoragePool::allocate(16*16*16);
+    for (int i = 0; i < 16*16*16; i++)
+      blocks[i] = quint8(indices[i]);
+  } else {
+    blockBits = 16;
+    blocks = StoragePool::allocate(16*16*16 * sizeof(quint16));
+    memcpy(blocks, indices, 16*16*16 * sizeof(quint16));
+  }
+}
+
+void ChunkSection::setBlocksUniform(quint16 index) {
+  StoragePool::release(blocks, (16*16*16 * blockBits) / 8);
+  blocks       = nullptr;
+  blockBits    = 0;
+  blockUniform = index;
+}
+
+void ChunkSection::updateMasks() {
+  StoragePool::release(reinterpret_cast<quint8 *>(masks.loadAcquire()), mskCount * 16*16 * sizeof(quint16));
+  masks.storeRelease(nullptr);
+
+  // mixed Sections build their column masks when first needed
+  if (isUniform()) {
+    maskUniform = 0;
+    if (blockPaletteLength > 0)
+      maskUniform = getMaskAttributes(blockPalette[(blockUniform < blockPaletteLength) ? blockUniform : 0]);
   }
+}
+
+// attributes of a Block state as BlockMask bits
+quint8 ChunkSection::getMaskAttributes(quint32 stateId) {
+  const BlockInfo &block = BlockIdentifier::Instance().getBlockInfo(
+                             BlockStateRegistry::Instance().getPaletteEntry(stateId).hid);
+  return ((block.alpha != 0.0)                  << mskVisible) |
+         (block.isLiquid()                      << mskLiquid) |
+         (block.doesBlockHaveSolidTopSurface()  << mskSolidTop) |
+         (block.transparent                     << mskTransparent) |
+         (block.isBlockNormalCube()             << mskNormalCube) |
+         (block.spawninside                     << mskSpawnInside) |
+         (block.isBedrock()                     << mskBedrock);
+}
+
+// may be called by several threads at once, only the first result is kept
+const quint16 *ChunkSection::buildMasks() const {
+  QVarLengthArray<quint8, 64> attributes(std::max(1, blockPaletteLength));
+  attributes[0] = 0;
+  for (int j = 0; j < blockPaletteLength; j++)
+    attributes[j] = getMaskAttributes(blockPalette[j]);
+
+  quint16 *built = reinterpret_cast<quint16 *>(StoragePool::allocate(mskCount * 16*16 * sizeof(quint16)));
+  for (int offset = 0; offset < 16*16*16; offset++) {
+    quint16 index = getBlockIndex(offset);
+    quint8  attr  = attributes[(index < blockPaletteLength) ? index : 0];
+    quint16 bit   = 1 << (offset >> 8);
+    int column    = offset & 0xff;
+    for (int m = 0; m < mskCount; m++)
+      if (attr & (1 << m))
+        built[m * 16*16 + column] |= bit;
+  }
+
+  if (!masks.testAndSetOrdered(nullptr, built)) {
+    StoragePool::release(reinterpret_cast<quint8 *>(built), mskCount * 16*16 * sizeof(quint16));
+    return masks.loadAcquire();
+  }
+  return built;
+}
+
+void ChunkSection::setBiomes(const quint16 *ids) {
+  bool uniform = true;
+  for (int i = 1; i < 4*4*4; i++)
+    uniform &= (ids[i] == ids[0]);
+  if (uniform) {
+    setBiomesUniform(ids[0]);
+    return;
+  }
+  if (biomes == nullptr)
+    biomes = reinterpret_cast<quint16 *>(StoragePool::allocate(4*4*4 * sizeof(quint16)));
+  memcpy(biomes, ids, 4*4*4 * sizeof(quint16));
+}
+
+void ChunkSection::setBiomesUniform(quint16 id) {
+  StoragePool::release(reinterpret_cast<quint8 *>(biomes), 4*4*4 * sizeof(quint16));
+  biomes       = nullptr;
+  biomeUniform = id;
+}
+
+void ChunkSection::setBlockLight(const quint8 *nibbles) {
+  bool dark = true;
+  for (int i = 0; (i < 16*16*16/2) && dark; i++)
+    dark = (nibbles[i] == 0);
+  if (dark) {
+    StoragePool::release(blockLight, 16*16*16/2);
+    blockLight = nullptr;
+    return;
+  }
+  if (blockLight == nullptr)
+    blockLight = StoragePool::allocate(16*16*16/2);
+  memcpy(blockLight, nibbles, 16*16*16/2);
+}
+
+int ChunkSection::getMemoryUsage() const {
+  int size = sizeof(ChunkSection);
+  size += (16*16*16 * blockBits) / 8;
+  if (biomes)     size += 4*4*4 * sizeof(quint16);
+  if (blockLight) size += 16*16*16/2;
+  if (masks.loadAcquire()) size += mskCount * 16*16 * sizeof(quint16);
+  size += blockPaletteLength * sizeof(quint32);
+  return size;
+}
+
+void ChunkSection::allocatePalette(int length) {
+  releasePalette();
+  blockPalette = PalettePool::allocate(length);
+  blockPaletteLength = length;
+}
+
+void ChunkSection::releasePalette() {
+  PalettePool::release(blockPalette, blockPaletteLength);
   blockPaletteLength = 0;
   blockPalette = NULL;
 }
@@ -748,14 +991,6 @@ const PaletteEntry & ChunkSection::getPaletteEntry(int offset, int y) const {
   return getPaletteEntry(offset + yoffset);
 }
 
-const PaletteEntry & ChunkSection::getPaletteEntry(int offset) const {
-  quint16 blockid = blocks[offset];
-  if (blockid < blockPaletteLength)
-    return blockPalette[blockid];
-  else
-    return blockPalette[0];
-}
-
 quint16 ChunkSection::getBiome(int x, int y, int z) const {
   int xoffset = x;
   int yoffset = (y & 0x0f) << 8;
@@ -769,6 +1004,8 @@ quint16 ChunkSection::getBiome(int offset, int y) const {
 }
 
 quint16 ChunkSection::getBiome(int offset) const {
+  if ((biomes == nullptr) || (offset < 0) || (offset >= 4*4*4))
+    return biomeUniform;
   return biomes[offset];
 }
 
@@ -800,9 +1037,3 @@ quint8 ChunkSection::getBlockLight(int offset, int y) const {
   return getBlockLight(offset + yoffset);
 }
 
-inline
-quint8 ChunkSection::getBlockLight(int offset) const {
-  int value = blockLight[offset / 2];
-  if (offset & 1) value >>= 4;
-  return value & 0x0f;
-}
@@ -6,20 +6,33 @@
 #include <QVector>
 #include <array>
 
+#include "memorypool.h"
+#include "identifier/blockstateregistry.h"
 #include "nbt/nbt.h"
 #include "overlay/entity.h"
 #include "overlay/generatedstructure.h"
 #include "paletteentry.h"
+#include "rendervariant.h"
 
 
-class ChunkSection {
+class ChunkSection : public PooledObject<ChunkSection> {
  public:
   ChunkSection();
   ~ChunkSection();
 
+  // palette arrays are recycled by a pool (MaxLength: one entry per Block)
+  typedef ArrayPool<quint32, 16*16*16> PalettePool;
+  void allocatePalette(int length);
+  void releasePalette();
+
+  // storage arrays (Blocks, Biomes, Light) are recycled by a pool
+  typedef ArrayPool<quint8, 16*16*16*2> StoragePool;
+
   const PaletteEntry & getPaletteEntry(int x, int y, int z) const;
   const PaletteEntry & getPaletteEntry(int offset, int y) const;
   const PaletteEntry & getPaletteEntry(int offset) const;
+  quint16 getBlockIndex(int offset) const;  // index into blockPalette
+  quint32 getStateId(int offset) const;     // ID in BlockStateRegistry
   quint16 getBiome(int x, int y, int z) const;
   quint16 getBiome(int offset, int y) const;
   quint16 getBiome(int offset) const;
@@ -30,18 +43,102 @@ class ChunkSection {
   quint8 getBlockLight(int offset, int y) const;
   quint8 getBlockLight(int offset) const;
 
-  PaletteEntry *blockPalette;
+  // store data in the most compact representation
+  void setBlocks(const quint16 *indices);       // 16*16*16 palette indices
+  void setBlocksUniform(quint16 index);         // all Blocks use the same palette index
+  void setBiomes(const quint16 *ids);           // 4*4*4 Biome IDs
+  void setBiomesUniform(quint16 id);            // all Blocks are in the same Biome
+  void setBlockLight(const quint8 *nibbles);    // 16*16*16/2 packed light values
+
+  // per column bit masks with one bit for each Y in this Section,
+  // to skip uninteresting Blocks without BlockInfo lookup,
+  // built on first use: only Sections reached by the renderer carry them
+  enum BlockMask {
+    mskVisible = 0,   // alpha != 0 (not air)
+    mskLiquid,
+    mskSolidTop,      // doesBlockHaveSolidTopSurface()
+    mskTransparent,   // BlockInfo::transparent (used in cave mode)
+    mskNormalCube,    // isBlockNormalCube()
+    mskSpawnInside,   // mobs can spawn inside this Block
+    mskBedrock,
+    mskCount
+  };
+  void    updateMasks();  // call after palette and Blocks are set
+  quint16 getColumnMask(BlockMask mask, int offset) const;  // offset: x + 16*z (thread safe)
+
+  bool isUniform() const { return blockBits == 0; }
+  bool hasBlockLight() const { return blockLight != nullptr; }
+  int  getMemoryUsage() const;                  // bytes allocated for this Section
+
+  quint32   *blockPalette;        // IDs in BlockStateRegistry
   int        blockPaletteLength;
-  bool       blockPaletteIsShared;
 
-  quint16 blocks[16*16*16];       // index into blockPalette for each Block
-  quint16 biomes[4*4*4];          // key into BiomeIdentifer for each 4x4x4 volume of Blocks defining the Biome
-//quint8  skyLight[16*16*16/2];   // not needed in Minutor
-  quint8  blockLight[16*16*16/2]; // light value for each Block
+ private:
+  void releaseStorage();
+  const quint16 *buildMasks() const;
+  static quint8 getMaskAttributes(quint32 stateId);
+
+  // Block storage, bits used per palette index:
+  //  0: all Blocks share blockUniform, no array allocated
+  //  4: two indices packed in one byte (palettes up to 16 entries)
+  //  8: one byte per index (palettes up to 256 entries)
+  // 16: one quint16 per index (big palettes and legacy virtual IDs)
+  quint8   blockBits;
+  quint16  blockUniform;
+  quint8  *blocks;          // packed index into blockPalette for each Block
+  quint16  biomeUniform;
+  quint16 *biomes;          // key into BiomeIdentifer for each 4x4x4 volume of Blocks defining the Biome, nullptr when uniform
+//quint8  *skyLight;        // not needed in Minutor
+  quint8  *blockLight;      // light value for each Block, nullptr when all dark
+  quint8   maskUniform;     // one bit per BlockMask when all Blocks are the same
+  mutable QAtomicPointer<quint16> masks;  // [BlockMask][column] bit per Y, nullptr when uniform or not yet used
 };
 
 
-class Chunk : public QObject {
+inline quint16 ChunkSection::getBlockIndex(int offset) const {
+  switch (blockBits) {
+    case 4:
+      return (blocks[offset >> 1] >> ((offset & 1) << 2)) & 0x0f;
+    case 8:
+      return blocks[offset];
+    case 16:
+      return reinterpret_cast<const quint16 *>(blocks)[offset];
+    default:
+      return blockUniform;
+  }
+}
+
+inline quint32 ChunkSection::getStateId(int offset) const {
+  quint16 blockid = getBlockIndex(offset);
+  if (blockid < blockPaletteLength)
+    return blockPalette[blockid];
+  else
+    return blockPalette[0];
+}
+
+inline const PaletteEntry & ChunkSection::getPaletteEntry(int offset) const {
+  return BlockStateRegistry::Instance().getPaletteEntry(getStateId(offset));
+}
+
+inline quint16 ChunkSection::getColumnMask(BlockMask mask, int offset) const {
+  if (isUniform())
+    return (maskUniform & (1 << mask)) ? 0xffff : 0;
+  const quint16 *columns = masks.loadAcquire();
+  if (columns == nullptr)
+    columns = buildMasks();
+  return columns[mask * 16*16 + offset];
+}
+
+inline quint8 ChunkSection::getBlockLight(int offset) const {
+  if (blockLight == nullptr)
+    return 0;
+  int value = blockLight[offset / 2];
+  if (offset & 1) value >>= 4;
+  return value & 0x0f;
+}
+
+
+class Chunk : public QObject, public PooledObject<Chunk> {
   Q_OBJECT
 
  public:
@@ -56,6 +153,7 @@ class Chunk : public QObject {
   const uchar * getImage() const { return image; }
   int  getHighest() const { return highest; }
   int  getLowest() const  { return lowest; }
+  int  getColumnTop(int offset) const;  // Y of highest non-air Block in column (or upper bound)
 
   const ChunkSection* getSectionByY(int y) const;
   const ChunkSection* getSectionByIdx(qint8 y) const;
@@ -73,8 +171,11 @@ class Chunk : public QObject {
   Only valid if getIsChunkLocked() returns true. */
   const QString & getChunkLockItemName() const { return chunkLockItemName; }
 
- signals:
-  void structureFound(QSharedPointer<GeneratedStructure> structure);
+  /** Hands over the structures found while loading (only once). */
+  QList<QSharedPointer<GeneratedStructure>> takeStructures();
+
+  /** Takes over Entities (and ChunkLock state) loaded separately into other. */
+  void takeEntities(Chunk &other);
 
  protected:
   bool loadSection1343(ChunkSection * cs, const Tag * section);
@@ -90,6 +191,7 @@ class Chunk : public QObject {
   int  renderedFlags;
   bool loaded;
   bool rendering;
+  bool entitiesLoaded;  // Entities are present (or will be added by the running loader)
   long long inhabitedTime;
 
   QVector<ChunkSection*> sections;
@@ -97,7 +199,24 @@ class Chunk : public QObject {
   qint32 biomes[16 * 16 * 4]; // before "The Flattining" it was 1*16*16*Bytes, then it got 16*4*4*4*Int before it moved into Sections
   uchar  image[16 * 16 * 4];  // cached render: RGBA for 16*16 Blocks
   short  depth[16 * 16];      // cached depth map to create shadow
+  // results of the render base pass, overlays are applied from these
+  uchar  baseImage[16 * 16 * 4];  // blended Block colors
+  uchar  baseShade[16 * 16];      // blended depth shading
+  uchar  baseCave[16 * 16];       // cave mode darkening (255 = none)
+  uchar  baseSamples[16 * 16];    // number of blended Blocks
+  uchar  topLight[16 * 16];       // light value at top Block
+  qint16 topBiome[16 * 16];       // Biome ID of top Block
+  static const qint16 noBiome = -32768;  // no Block found in column
+  // most recent base pass results for different depth / flags, newest first
+  // (only cached Chunks displayed by MapView, accessed from GUI thread only)
+  RenderVariantList renderVariants;
+  void storeRenderVariant();
+  bool restoreRenderVariant(int depth, int flags);
+  void releaseRenderVariants();
+  short  surface[16 * 16];    // highest non-air Block per column (from Heightmaps)
+  bool   hasSurface;          // surface is valid, otherwise columns have to be scanned
   EntityMap entities;
+  QList<QSharedPointer<GeneratedStructure>> structures;  // found during load, until taken
 
   // ChunkLocked feature:
   bool    isChunkLocked;      // flag specifies whether the chunk is locked by the ChunkLock resourcepack
@@ -109,12 +228,16 @@ class Chunk : public QObject {
   friend class MapView;
   friend class ChunkRenderer;
   friend class ChunkCache;
+  friend class ChunkLoader;
+  friend class TileBuilder;
+  friend class RenderVariantList;
 
  private:
   void findHighestBlock();
   void setSectionByIdx(qint8 y, ChunkSection *cs);
   void loadLevelTag(const Tag * levelTag);  // nested structure with Level tag (up to 1.17)
   void loadCliffsCaves(const NBT &nbt);     // flat structure without Level tag (1.18+)
+  void loadHeightmaps(const QString &status, const Tag * heightmapsTag, int minY);
   void loadSection_decodeBlockPalette(ChunkSection * cs, const Tag * paletteTag);
   void loadSection_createDummyPalette(ChunkSection * cs);
   void loadSection_loadBlockStates(ChunkSection *cs, const Tag * blockStateTag);
@@ -124,4 +247,9 @@ class Chunk : public QObject {
   void loadCheckEntityChunkLock(const Tag * entityNbt);
 };
 
+
+inline int Chunk::getColumnTop(int offset) const {
+  return hasSurface ? surface[offset] : highest;
+}
+
 #endif  // CHUNK_H_
@@ -1,5 +1,7 @@
 /** Copyright (c) 2013, Sean Kasun */
 
+#include <cmath>
+
 #include "chunkcache.h"
 #include "chunkloader.h"
 
@@ -14,8 +16,15 @@
 #endif
 
 ChunkCache::ChunkCache() {
-  const int sizeChunkMax     = sizeof(Chunk) + 16 * sizeof(ChunkSection);  // all sections contain Blocks
-  const int sizeChunkTypical = sizeof(Chunk) + 6 * sizeof(ChunkSection);   // world generation is average Y=64..128
+  // Sections are stored compact: uniform Sections have no Block array, light only when not dark
+  const int sizePalette        = 16 * sizeof(quint32);  // typical palette, Block states are stored in BlockStateRegistry
+  const int sizeMasks          = ChunkSection::mskCount * 16*16 * sizeof(quint16);
+  const int sizeSectionMax     = sizeof(ChunkSection) + sizePalette + 16*16*16*sizeof(quint16) + 16*16*16/2 + 4*4*4*sizeof(quint16) + sizeMasks;
+  const int sizeSectionTypical = sizeof(ChunkSection) + sizePalette + 16*16*16/2;  // 4 bit palette index
+  const int sizeChunkMax     = sizeof(Chunk) + 24 * sizeSectionMax;      // all sections contain Blocks
+  const int sizeChunkTypical = sizeof(Chunk) + 8 * sizeSectionTypical +  // world generation is average Y=-64..64
+                               16 * sizeof(ChunkSection) +               // and the rest is uniform (air)
+                               2 * sizeMasks;                            // masks only near the rendered surface
 
   // default: 10% more than 1920x1200 blocks
   int chunks = 10000;
@@ -47,12 +56,20 @@ ChunkCache::ChunkCache() {
   // we start the Cache based on worst case calculation
   cache.setMaxCost(chunks);
 
+  entitiesNeeded = 0;
+  generation     = 0;
+
+  // rendered variants get a fixed share of the Chunk memory
+  renderMemory    = 0;
+  renderMemoryMax = qint64(maxcache) * sizeChunkTypical / 16;
+
   // determain optimal thread pool size for "loading"
   // as this contains disk access, use less than number of cores
   int tmax = loaderThreadPool.maxThreadCount();
   loaderThreadPool.setMaxThreadCount(tmax / 2);
 
-  qRegisterMetaType<QSharedPointer<GeneratedStructure>>("QSharedPointer<GeneratedStructure>");
+  qRegisterMetaType<QList<QSharedPointer<GeneratedStructure>>>("QList<QSharedPointer<GeneratedStructure>>");
+  qRegisterMetaType<QSharedPointer<Chunk>>("QSharedPointer<Chunk>");
 }
 
 ChunkCache::~ChunkCache() {
@@ -66,9 +83,19 @@ ChunkCache& ChunkCache::Instance() {
 
 void ChunkCache::clear() {
   QThreadPool::globalInstance()->waitForDone();
+  loaderThreadPool.waitForDone();
+  // no renderer or loader is running now, pages replaced by definition changes can go
+  BlockStateRegistry::Instance().releaseRetiredPages();
 
-  QMutexLocker guard(&mutex);
-  cache.clear();
+  {
+    QMutexLocker guard(&mutex);
+    cache.clear();
+  }
+  entitiesLoading.clear();
+  generation++;  // Entities still queued for delivery belong to the old Chunks
+  QMutexLocker guard(&structureMutex);
+  structuresSeen.clear();
+  structureTypes.clear();
 }
 
 void ChunkCache::setPath(QString path) {
@@ -92,6 +119,42 @@ int ChunkCache::getMemoryMax() const {
   return maxcache;
 }
 
+bool ChunkCache::reserveRenderMemory(int bytes) {
+  if (renderMemory.fetchAndAddRelaxed(bytes) + bytes > renderMemoryMax) {
+    renderMemory.fetchAndAddRelaxed(-bytes);
+    return false;
+  }
+  return true;
+}
+
+void ChunkCache::releaseRenderMemory(int bytes) {
+  renderMemory.fetchAndAddRelaxed(-bytes);
+}
+
+qint64 ChunkCache::getRenderMemoryUsage() const {
+  return renderMemory.loadAcquire();
+}
+
+void ChunkCache::setEntitiesNeeded(bool needed) {
+  entitiesNeeded.storeRelease(needed ? 1 : 0);
+}
+
+bool ChunkCache::getEntitiesNeeded() const {
+  return entitiesNeeded.loadAcquire() != 0;
+}
+
+void ChunkCache::fetchEntities(int cx, int cz) {
+  ChunkID id(cx, cz);
+  if (entitiesLoading.contains(id))
+    return;  // already loading
+  entitiesLoading.insert(id);
+
+  ChunkLoader *loader = new ChunkLoader(path, cx, cz, ChunkLoader::SEPARATED_ENTITIES, generation);
+  connect(loader, SIGNAL(entitiesLoaded(int, int, int, QSharedPointer<Chunk>)),
+          this,   SLOT(gotEntities(int, int, int, QSharedPointer<Chunk>)));
+  loaderThreadPool.start(loader);
+}
+
 QSharedPointer<Chunk> ChunkCache::fetchCached(int cx, int cz) {
   // try to get Chunk from Cache
   ChunkID id(cx, cz);
@@ -138,8 +201,6 @@ QSharedPointer<Chunk> ChunkCache::fetch(int cx, int cz) {
 
   // launch background process to load this chunk
   QSharedPointer<Chunk> * p_chunk = new QSharedPointer<Chunk>(new Chunk());
-  connect(p_chunk->data(), SIGNAL(structureFound(QSharedPointer<GeneratedStructure>)),
-          this,            SLOT  (routeStructure(QSharedPointer<GeneratedStructure>)));
 
   {
     QMutexLocker guard(&mutex);
@@ -148,12 +209,16 @@ QSharedPointer<Chunk> ChunkCache::fetch(int cx, int cz) {
   ChunkLoader *loader = new ChunkLoader(path, cx, cz);
   connect(loader, SIGNAL(loaded(int, int)),
           this,   SLOT(gotChunk(int, int)));
+  connect(loader, SIGNAL(structuresFound(QList<QSharedPointer<GeneratedStructure>>)),
+          this,   SLOT(routeStructures(QList<QSharedPointer<GeneratedStructure>>)));
   loaderThreadPool.start(loader);
   return QSharedPointer<Chunk>(NULL);
 }
 
-QSharedPointer<Chunk> ChunkCache::getChunkSynchronously(const ChunkID& id)
+QSharedPointer<Chunk> ChunkCache::getChunkSynchronously(const ChunkID& id, bool withEntities)
 {
+  // Entities also when they are shown, as the Chunk may end in the Cache
+  withEntities |= getEntitiesNeeded();
   QSharedPointer<Chunk> chunk;
   bool hasFreeSpaceInCache = false;
   {
@@ -161,18 +226,26 @@ QSharedPointer<Chunk> ChunkCache::getChunkSynchronously(const ChunkID& id)
     hasFreeSpaceInCache = (cache.totalCost() < cache.maxCost() * 0.9);
 
     const CacheState state = getCached_intern(id, chunk);
-    if (state == CacheState::cached)
+    // a cached Chunk without Entities is not modified here, load a separate one instead
+    if ((state == CacheState::cached) &&
+        (!chunk || chunk->entitiesLoaded || !withEntities))
       return chunk;
+    if (chunk)
+      hasFreeSpaceInCache = false;  // keep the cached one
   }
 
-  // sychronously load
-  chunk = QSharedPointer<Chunk>::create();
+  // sychronously load (Chunk memory is taken from its pool)
+  chunk = QSharedPointer<Chunk>(new Chunk());
 
-  if (!ChunkLoader::loadNbt(path, id.getX(), id.getZ(), chunk))
+  if (!ChunkLoader::loadNbt(path, id.getX(), id.getZ(), chunk, withEntities))
   {
     return QSharedPointer<Chunk>();
   }
 
+  auto structures = filterNewStructures(chunk->takeStructures());
+  if (!structures.isEmpty())
+    emit structuresFound(structures);
+
   if (hasFreeSpaceInCache && chunk->loaded) // only cache in case of lot of memory to not degrade drawing performance
   {
     QMutexLocker guard(&mutex);
@@ -186,8 +259,44 @@ void ChunkCache::gotChunk(int cx, int cz) {
   emit chunkLoaded(cx, cz);
 }
 
-void ChunkCache::routeStructure(QSharedPointer<GeneratedStructure> structure) {
-  emit structureFound(structure);
+void ChunkCache::gotEntities(int cx, int cz, int generation, QSharedPointer<Chunk> entities) {
+  if (generation != this->generation)
+    return;  // loaded before clear(), maybe from another world or dimension
+  entitiesLoading.remove(ChunkID(cx, cz));
+  if (!entities)
+    return;  // Chunk was dropped from Cache meanwhile
+
+  QSharedPointer<Chunk> chunk(fetchCached(cx, cz));
+  if (chunk && !chunk->entitiesLoaded) {
+    chunk->takeEntities(*entities);
+    emit entitiesLoaded(cx, cz);
+  }
+}
+
+void ChunkCache::routeStructures(QList<QSharedPointer<GeneratedStructure>> structures) {
+  emit structuresFound(structures);
+}
+
+QList<QSharedPointer<GeneratedStructure>> ChunkCache::filterNewStructures(const QList<QSharedPointer<GeneratedStructure>> &structures) {
+  QList<QSharedPointer<GeneratedStructure>> found;
+  if (structures.isEmpty())
+    return found;
+
+  QMutexLocker guard(&structureMutex);
+  for (auto &structure : structures) {
+    // structures are identified by type and position
+    const QString type = structure->type();
+    auto it = structureTypes.constFind(type);
+    if (it == structureTypes.constEnd())
+      it = structureTypes.insert(type, structureTypes.size());
+    OverlayItem::Point p = structure->midpoint();
+    StructureKey key{it.value(), qint32(floor(p.x)), qint32(floor(p.y)), qint32(floor(p.z))};
+    if (!structuresSeen.contains(key)) {
+      structuresSeen.insert(key);
+      found.append(structure);
+    }
+  }
+  return found;
 }
 
 void ChunkCache::setCacheMaxSize(int chunks) {
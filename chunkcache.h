@@ -33,28 +33,62 @@ class ChunkCache : public QObject {
   QSharedPointer<Chunk> fetch(int cx, int cz);         // fetch Chunk and load when not found
   QSharedPointer<Chunk> fetchCached(int cx, int cz);   // fetch Chunk only if cached
   CacheState getCached(const ChunkID& id, QSharedPointer<Chunk>& chunk_out);    // fetch Chunk only if cached, can tell if just not loaded or empty
-  QSharedPointer<Chunk> getChunkSynchronously(const ChunkID& id);         // get chunk if cached directly, or load it in a synchronous blocking way
+  QSharedPointer<Chunk> getChunkSynchronously(const ChunkID& id, bool withEntities);  // get chunk if cached directly, or load it in a synchronous blocking way
   int getCacheUsage() const;
   int getCacheMax() const;
   int getMemoryMax() const;
 
+  // memory budget for additional rendered variants of cached Chunks
+  bool reserveRenderMemory(int bytes);
+  void releaseRenderMemory(int bytes);
+  qint64 getRenderMemoryUsage() const;
+
+  // Entities are loaded only while they are shown (separate Entity files since 1.17)
+  void setEntitiesNeeded(bool needed);
+  bool getEntitiesNeeded() const;
+  void fetchEntities(int cx, int cz);                   // load Entities of a cached Chunk later on
+
+  // removes structures already reported since the last clear() (thread safe)
+  QList<QSharedPointer<GeneratedStructure>> filterNewStructures(const QList<QSharedPointer<GeneratedStructure>> &structures);
+
  signals:
   void chunkLoaded(int cx, int cz);
-  void structureFound(QSharedPointer<GeneratedStructure> structure);
+  void entitiesLoaded(int cx, int cz);
+  void structuresFound(QList<QSharedPointer<GeneratedStructure>> structures);
 
  public slots:
   void setCacheMaxSize(int chunks);
 
  private slots:
   void gotChunk(int cx, int cz);
-  void routeStructure(QSharedPointer<GeneratedStructure> structure);
+  void gotEntities(int cx, int cz, int generation, QSharedPointer<Chunk> entities);
+  void routeStructures(QList<QSharedPointer<GeneratedStructure>> structures);
 
  private:
   QString path;                                   // path to folder with region files
+  QAtomicInteger<qint64> renderMemory;            // bytes used by rendered variants (Chunks release it on destruction)
+  qint64 renderMemoryMax;                         // budget for rendered variants
   QCache<ChunkID, QSharedPointer<Chunk>> cache;   // real Cache
   QMutex mutex;                                   // Mutex for accessing the Cache
   int maxcache;                                   // number of Chunks that fit into memory
   QThreadPool loaderThreadPool;                   // extra thread pool for loading
+  QAtomicInt entitiesNeeded;                      // load Entities together with Chunks
+  QSet<ChunkID> entitiesLoading;                  // separate Entity loads in progress (GUI thread only)
+  int generation;                                 // incremented by clear() (GUI thread only)
+  // reported structures are identified by type and Block position
+  struct StructureKey {
+    quint32 type;  // index in structureTypes
+    qint32  x, y, z;
+    bool operator==(const StructureKey &other) const {
+      return (type == other.type) && (x == other.x) && (y == other.y) && (z == other.z);
+    }
+  };
+  friend uint qHash(const StructureKey &key, uint seed) {
+    return qHash((quint64(quint32(key.x)) << 32) | quint32(key.z), seed) ^ (key.y * 31) ^ (key.type * 1021);
+  }
+  QHash<QString, quint32> structureTypes;         // type name -> compact ID for StructureKey
+  QSet<StructureKey> structuresSeen;              // keys of reported structures
+  QMutex structureMutex;                          // Mutex for accessing structuresSeen
 
   CacheState getCached_intern(const ChunkID& id, QSharedPointer<Chunk>& chunk_out);
 };
@@ -5,9 +5,11 @@
 #include "chunk.h"
 
 
-ChunkLoader::ChunkLoader(QString path, int cx, int cz)
+ChunkLoader::ChunkLoader(QString path, int cx, int cz, CHUNKLOAD_TYPE loadtype, int generation)
   : path(path)
   , cx(cx), cz(cz)
+  , loadtype(loadtype)
+  , generation(generation)
   , cache(ChunkCache::Instance())
 {}
 
@@ -17,12 +19,31 @@ ChunkLoader::~ChunkLoader()
 void ChunkLoader::run() {
   // get existing Chunk entry from Cache
   QSharedPointer<Chunk> chunk(cache.fetchCached(cx, cz));
-  // load & parse NBT data
-  loadNbt(path, cx, cz, chunk);
+
+  if (loadtype == SEPARATED_ENTITIES) {
+    // the cached Chunk may be in use, Entities are parsed into a temporary one
+    // and handed over in the GUI thread
+    QSharedPointer<Chunk> temp;
+    if (chunk) {
+      temp = QSharedPointer<Chunk>(new Chunk());
+      temp->version = chunk->version;
+      loadEntities(path, cx, cz, temp);
+    }
+    emit entitiesLoaded(cx, cz, generation, temp);
+    return;
+  }
+
+  // load & parse NBT data (Entities only when they are shown)
+  if (loadNbt(path, cx, cz, chunk, cache.getEntitiesNeeded())) {
+    // report structures as one batch, already reported ones are dropped here
+    auto structures = cache.filterNewStructures(chunk->takeStructures());
+    if (!structures.isEmpty())
+      emit structuresFound(structures);
+  }
   emit loaded(cx, cz);
 }
 
-bool ChunkLoader::loadNbt(QString path, int cx, int cz, QSharedPointer<Chunk> chunk)
+bool ChunkLoader::loadNbt(QString path, int cx, int cz, QSharedPointer<Chunk> chunk, bool withEntities)
 {
   // check if chunk is a valid storage
   if (!chunk) {
@@ -33,17 +54,31 @@ bool ChunkLoader::loadNbt(QString path, int cx, int cz, QSharedPointer<Chunk> ch
   int rx = cx >> 5;
   int rz = cz >> 5;
 
-  QString filename;
+  // flag before the Chunk becomes "loaded", so no separate Entity load gets triggered
+  if (withEntities)
+    chunk->entitiesLoaded = true;
 
-  filename = path + "/region/r." + QString::number(rx) + "." + QString::number(rz) + ".mca";
+  QString filename = path + "/region/r." + QString::number(rx) + "." + QString::number(rz) + ".mca";
   bool result = loadNbtHelper(filename, cx, cz, chunk, ChunkLoader::MAIN_MAP_DATA);
 
-  filename = path + "/entities/r." + QString::number(rx) + "." + QString::number(rz) + ".mca";
-  loadNbtHelper(filename, cx, cz, chunk, ChunkLoader::SEPARATED_ENTITIES);
+  if (withEntities)
+    loadEntities(path, cx, cz, chunk);
 
   return result;
 }
 
+bool ChunkLoader::loadEntities(QString path, int cx, int cz, QSharedPointer<Chunk> chunk)
+{
+  // check if chunk is a valid storage
+  if (!chunk) {
+    return false;
+  }
+
+  // Entities are stored in an extra folder (1.17+)
+  QString filename = path + "/entities/r." + QString::number(cx >> 5) + "." + QString::number(cz >> 5) + ".mca";
+  return loadNbtHelper(filename, cx, cz, chunk, ChunkLoader::SEPARATED_ENTITIES);
+}
+
 bool ChunkLoader::loadNbtHelper(QString filename, int cx, int cz, QSharedPointer<Chunk> chunk, int loadtype)
 {
   QFile f(filename);
@@ -53,66 +88,63 @@ bool ChunkLoader::loadNbtHelper(QString filename, int cx, int cz, QSharedPointer
     return false;
   }
 
+  const qint64 size = f.size();
+  uchar *region = f.map(0, size);
+  if (region == NULL) {
+    f.close();
+    return false;
+  }
+  bool result = loadNbtMapped(region, size, cx, cz, chunk, loadtype);
+  f.unmap(region);
+  f.close();
+  return result;
+}
+
+bool ChunkLoader::loadNbtMapped(const uchar *region, qint64 size, int cx, int cz, QSharedPointer<Chunk> chunk, int loadtype)
+{
   const int headerSize = 4096;
 
-  if (f.size() < headerSize) {
+  if (size < headerSize) {
     // file header not yet fully written by minecraft
     return false;
   }
 
-  // map header into memory
-  uchar *header = f.map(0, headerSize);
+  // location of Chunk from header
   int offset = 4 * ((cx & 31) + (cz & 31) * 32);
 
-  int coffset = (header[offset] << 16) | (header[offset + 1] << 8) | header[offset + 2];
-  int numSectors = header[offset+3];
-  f.unmap(header);
+  int coffset = (region[offset] << 16) | (region[offset + 1] << 8) | region[offset + 2];
+  int numSectors = region[offset+3];
 
   if (coffset == 0) {
     // no Chunk information stored in region file
-    f.close();
     return false;
   }
 
-  const int chunkStart = coffset * 4096;
+  const qint64 chunkStart = qint64(coffset) * 4096;
   const int chunkSize = numSectors * 4096;
 
   // Check if chunk header (5 bytes: 4 length + 1 compression) is readable
-  if (f.size() < chunkStart + 5) {
-    f.close();
+  if (size < chunkStart + 5) {
     return false;
   }
 
   // Read chunk header to get actual data length
-  f.seek(chunkStart);
-  char headerBuf[4];
-  if (f.read(headerBuf, 4) != 4) {
-    f.close();
-    return false;
-  }
-  const uchar *hdr = reinterpret_cast<const uchar*>(headerBuf);
+  const uchar *hdr = region + chunkStart;
   int actualLength = (hdr[0] << 24) | (hdr[1] << 16) | (hdr[2] << 8) | hdr[3];
 
   // Sanity check: length must be positive and fit within allocated sectors
   if (actualLength <= 0 || actualLength + 4 > chunkSize) {
-    f.close();
     return false;
   }
 
   // Check actual data fits in file (handles unpadded files like WorldTools exports)
-  if (f.size() < chunkStart + 4 + actualLength) {
-    f.close();
+  if (size < chunkStart + 4 + actualLength) {
     return false;
   }
 
-  uchar *raw = f.map(chunkStart, actualLength + 4);
-  if (raw == NULL) {
-    f.close();
-    return false;
-  }
   // parse Chunk data
   // Chunk will be flagged "loaded" in a thread save way
-  NBT nbt(raw);
+  NBT nbt(region + chunkStart);
   switch (loadtype) {
     case ChunkLoader::MAIN_MAP_DATA:
       chunk->load(nbt);
@@ -120,8 +152,6 @@ bool ChunkLoader::loadNbtHelper(QString filename, int cx, int cz, QSharedPointer
     case ChunkLoader::SEPARATED_ENTITIES:
       chunk->loadEntities(nbt);
   }
-  f.unmap(raw);
-  f.close();
 
   // if we reach this point, everything went well
   return true;
@@ -10,19 +10,27 @@ class ChunkLoader : public QObject, public QRunnable {
   Q_OBJECT
 
  public:
-  ChunkLoader(QString path, int cx, int cz);
-  ~ChunkLoader();
-
   enum CHUNKLOAD_TYPE {
     MAIN_MAP_DATA      = 0,
     SEPARATED_ENTITIES = 1
   };
 
-  static bool loadNbt(QString path, int cx, int cz, QSharedPointer<Chunk> chunk);
+  // SEPARATED_ENTITIES: load only Entities for an already cached Chunk,
+  // generation is handed back to drop results of a cleared cache
+  ChunkLoader(QString path, int cx, int cz, CHUNKLOAD_TYPE loadtype = MAIN_MAP_DATA, int generation = 0);
+  ~ChunkLoader();
+
+  static bool loadNbt(QString path, int cx, int cz, QSharedPointer<Chunk> chunk, bool withEntities = true);
+  static bool loadEntities(QString path, int cx, int cz, QSharedPointer<Chunk> chunk);
   static bool loadNbtHelper(QString filename, int cx, int cz, QSharedPointer<Chunk> chunk, int loadtype);
+  // decode one Chunk from a Region file mapped as a whole (to load many Chunks of one Region)
+  static bool loadNbtMapped(const uchar *region, qint64 size, int cx, int cz, QSharedPointer<Chunk> chunk,
+                            int loadtype = MAIN_MAP_DATA);
 
  signals:
   void loaded(int cx, int cz);
+  void entitiesLoaded(int cx, int cz, int generation, QSharedPointer<Chunk> entities);  // temporary Chunk holding only Entities
+  void structuresFound(QList<QSharedPointer<GeneratedStructure>> structures);  // new ones only
 
  protected:
   void run();
@@ -30,6 +38,8 @@ class ChunkLoader : public QObject, public QRunnable {
  private:
   QString path;
   int     cx, cz;
+  CHUNKLOAD_TYPE loadtype;
+  int     generation;
   ChunkCache &cache;
 };
 
@@ -1,47 +1,131 @@
 /** Copyright (c) 2019, EtlamGit */
 
+#include <array>
+
 #include "chunk.h"
 #include "chunkrenderer.h"
 #include "chunkcache.h"
+#include "columnblend.h"
 #include "mapview.h"
 #include "identifier/blockidentifier.h"
 #include "identifier/biomeidentifier.h"
+#include "identifier/blockstateregistry.h"
 #include "clamp.h"
 #include "worldinfo.h"
 #include "java.h"
 
 ChunkRenderer::ChunkRenderer(int cx, int cz, int y, int flags)
-  : cx(cx)
+  : chunks({ChunkID(cx, cz)})
+  , cx(cx)
   , cz(cz)
   , depth(y)
   , flags(flags)
   , cache(ChunkCache::Instance())
 {}
 
-const std::vector<double> precomputed_light_factors = [] {
-    std::vector<double> table(16);
+ChunkRenderer::ChunkRenderer(const QList<ChunkID> &chunks, int y, int flags)
+  : chunks(chunks)
+  , cx(0)
+  , cz(0)
+  , depth(y)
+  , flags(flags)
+  , cache(ChunkCache::Instance())
+{}
+
+// light shading as multiply table: [light][color] = color * 0.9^(15-light)
+static const std::array<std::array<quint8, 256>, 16> lightMultiply = [] {
+    std::array<std::array<quint8, 256>, 16> table;
     for (int i = 0; i < 16; i++) {
-        table[i] = pow(0.90, 15 - i);
+        double factor = pow(0.90, 15 - i);
+        for (int c = 0; c < 256; c++)
+            table[i][c] = quint8(factor * c);
     }
     return table;
 }();
 
 void ChunkRenderer::run() {
-  // get existing Chunk entry from Cache
-  QSharedPointer<Chunk> chunk(cache.fetchCached(cx, cz));
-  // render Chunk data
-  if (chunk) {
-    renderChunk(chunk);
+  for (const ChunkID &id : chunks) {
+    cx = id.getX();
+    cz = id.getZ();
+    // get existing Chunk entry from Cache
+    QSharedPointer<Chunk> chunk(cache.fetchCached(cx, cz));
+    // render Chunk data
+    if (chunk) {
+      renderChunk(chunk);
+      chunk->rendering = false;
+    }
+  }
+  // one notification for the whole batch
+  emit rendered(chunks);
+}
+
+// view flags applied by the overlay pass, changing them needs no Block scan
+const int ChunkRenderer::overlayFlags = MapView::flgDepthShading | MapView::flgSlimeChunks |
+                                        MapView::flgInhabitedTime | MapView::flgBiomeColors;
+
+// depth-relative shade used by depth shading
+static const quint32 shadeTable[] = {
+  0, 12, 18, 22, 24, 26, 28, 29, 30, 31, 32};
+
+// test for Blocks that would be rendered in the Y range (lower, upper] of a column
+static bool hasVisibleBlock(const Chunk &chunk, int offset, int lower, int upper, bool seaGround) {
+  upper = std::min(upper, chunk.getHighest());
+  lower = std::max(lower, chunk.getLowest() - 1);
+  for (int y = upper; y > lower; ) {
+    int sec    = y >> 4;
+    int bottom = std::max(lower + 1, sec << 4);
+    const ChunkSection *section = chunk.getSectionByIdx(sec);
+    if (section) {
+      quint16 mask = section->getColumnMask(ChunkSection::mskVisible, offset);
+      if (seaGround)
+        mask &= ~section->getColumnMask(ChunkSection::mskLiquid, offset);
+      quint16 range = quint16(((2 << (y & 0x0f)) - 1) & ~((1 << (bottom & 0x0f)) - 1));
+      if (mask & range)
+        return true;
+    }
+    y = bottom - 1;
+  }
+  return false;
+}
+
+// column masks of the Blocks y-1 .. y+2 (bit 0 = y-1), missing Sections are air
+struct SpawnWindow {
+  quint32 bits[ChunkSection::mskCount];
+
+  SpawnWindow(const Chunk &chunk, int offset, int y) {
+    const int low = y - 1;
+    const ChunkSection *lower = chunk.getSectionByIdx(low >> 4);
+    const ChunkSection *upper = chunk.getSectionByIdx((low >> 4) + 1);
+    for (int m = 0; m < ChunkSection::mskCount; m++) {
+      auto mask = static_cast<ChunkSection::BlockMask>(m);
+      // air has no attributes, but mobs can spawn inside
+      const quint16 air = (mask == ChunkSection::mskSpawnInside) ? 0xffff : 0;
+      quint32 column = lower ? lower->getColumnMask(mask, offset) : air;
+      column |= quint32(upper ? upper->getColumnMask(mask, offset) : air) << 16;
+      bits[m] = (column >> (low & 0x0f)) & 0x0f;
+    }
   }
-  emit rendered(cx, cz);
+};
+
+// Drowned spawn needs water, that is no mask attribute
+static bool isBiomeWater(const Chunk &chunk, int offset, int y) {
+  const ChunkSection *section = chunk.getSectionByY(y);
+  if (!section) return false;
+  return BlockIdentifier::Instance().getBlockInfo(section->getPaletteEntry(offset, y).hid).biomeWater();
 }
 
 void ChunkRenderer::renderChunk(QSharedPointer<Chunk> chunk) {
+  renderBase(chunk);
+  renderOverlays(chunk);
+}
+
+// base pass: scan Blocks and blend colors, store everything the overlays need per column
+void ChunkRenderer::renderBase(QSharedPointer<Chunk> chunk) {
   // threshold for mob spawn detection
   const int lightSpawnSave = (chunk->version >= 2800)? 1 : 8;
 
   int offset = 0;
-  uchar *bits = chunk->image;
+  uchar *bits = chunk->baseImage;
   short *depthbits = chunk->depth;
 
   // adapt y loop start/stop value to render depth and available data in Chunk
@@ -52,39 +136,63 @@ void ChunkRenderer::renderChunk(QSharedPointer<Chunk> chunk) {
     stopY  = this->depth;
   }
 
-  bool isSlimeChunk = false;
-  if (this->flags & MapView::flgSlimeChunks) {
-    long long seed =
-        ( WorldInfo::Instance().getSeed() +
-          (int) (cx * cx * 0x4c1906) +
-          (int) (cx * 0x5ac0db) +
-          (int) (cz * cz) * 0x4307a7LL +
-          (int) (cz * 0x5f24f) ^ 0x3ad8025fLL );
-    if (Java::Random(seed).nextInt(10) == 0)
-      isSlimeChunk = true;
-  }
-
-  float regionalDifficulty = 0.0;
-  if (this->flags & MapView::flgInhabitedTime) {
-    // regional difficulty is max-capped at 3600000 ticks
-    long long inhabitedTime = std::min<long long>(chunk->inhabitedTime, 3600000);
-    regionalDifficulty = 6.0 * static_cast<double>(inhabitedTime) / 3600000.0;
-  }
+  BlockStateRegistry &registry = BlockStateRegistry::Instance();
+  BiomeTintCache     &tints    = BiomeTintCache::Instance();
+  const BiomeInfo *lastTintBiome = nullptr;  // last Biome tint lookup
+  QRgb lastTintBase  = 0;
+  int  lastTintY     = 0;
+  QRgb lastTintColor = 0;
 
   // flag to enable skipping all rendering stuff when transparent block is detected
-  bool doFastTransparentSkip = !((this->flags & MapView::flgBiomeColors) && (this->flags & MapView::flgSingleLayer));
+  // (in SingleLayer mode the Biome of air is needed for Biome colors)
+  bool doFastTransparentSkip = !(this->flags & MapView::flgSingleLayer);
+
+  // when only the depth changed, columns without Blocks between old and new
+  // depth keep their result (only depth shading of a single Block moves)
+  const bool incremental = (chunk->renderedAt != INT_MIN) &&
+                           ((chunk->renderedFlags & ~overlayFlags) == (this->flags & ~overlayFlags)) &&
+                           !(this->flags & MapView::flgSingleLayer);
+  const int changedLower = std::min(chunk->renderedAt, this->depth);
+  const int changedUpper = std::max(chunk->renderedAt, this->depth);
 
   // render loop
   for (int z = 0; z < 16; z++) {  // n->s
     // we do not know the last y value from Chunk to the east, -> set special value
     int lasty = -9999;
+    int oldLasty = -9999;
     for (int x = 0; x < 16; x++, offset++) {  // e->w
+      if (incremental) {
+        // edge highlight depends on the previous column, so it has to be unchanged too
+        int oldHighest = chunk->depth[offset];
+        bool unchanged = (lasty == oldLasty) && (chunk->baseSamples[offset] <= 1) &&
+                         !hasVisibleBlock(*chunk, offset, changedLower, changedUpper,
+                                          this->flags & MapView::flgSeaGround);
+        oldLasty = oldHighest;
+        if (unchanged) {
+          if (chunk->baseSamples[offset] == 1) {
+            size_t shadeIdx = std::min(static_cast<size_t>(this->depth - oldHighest),
+                                       sizeof(shadeTable) / sizeof(*shadeTable) - 1);
+            chunk->baseShade[offset] = shadeTable[shadeIdx];
+          }
+          lasty = oldHighest;
+          depthbits++;
+          bits += 4;
+          continue;
+        }
+      }
+
       // initialize color
-      uchar r = 0, g = 0, b = 0;
-      double alpha = 0.0;
+      ColumnBlend blend;  // colors and depth shade
+      int samples = 0;
+      chunk->topBiome[offset] = Chunk::noBiome;
+      chunk->topLight[offset] = 0;
 
       int highest = -4096;  // highest block in current column
-      for (int y = startY; y >= stopY; y--) {  // top->down
+      // start directly at the first non-air Block when Heightmap is known
+      int columnStartY = startY;
+      if (!(this->flags & MapView::flgSingleLayer))
+        columnStartY = std::min(startY, chunk->getColumnTop(offset));
+      for (int y = columnStartY; y >= stopY; y--) {  // top->down
         // perform a one deep scan in SingleLayer mode
         int sec = y >> 4;
         const ChunkSection *section = chunk->getSectionByIdx(sec);
@@ -93,11 +201,20 @@ void ChunkRenderer::renderChunk(QSharedPointer<Chunk> chunk) {
           continue;
         }
 
-        // get BlockInfo from block value
-        const BlockInfo &block = BlockIdentifier::Instance().getBlockInfo(section->getPaletteEntry(offset, y).hid);
-        if ((block.alpha == 0.0) && doFastTransparentSkip) continue;
+        // jump to the next relevant Block in this Section using the column masks
+        quint16 candidates = doFastTransparentSkip ? section->getColumnMask(ChunkSection::mskVisible, offset) : 0xffff;
+        if (this->flags & MapView::flgSeaGround)
+          candidates &= ~section->getColumnMask(ChunkSection::mskLiquid, offset);
+        candidates &= quint16((2 << (y & 0x0f)) - 1);  // only at or below current y
+        if (candidates == 0) {
+          y = (sec << 4);  // skip rest of section (for loop will do an additional decrement)
+          continue;
+        }
+        y = (sec << 4) + 15 - qCountLeadingZeroBits(candidates);
+        if (y < stopY) break;
 
-        if (this->flags & MapView::flgSeaGround && block.isLiquid()) continue;
+        // get precomputed color of this Block state
+        const BlockStateColor &block = registry.getStateColor(section->getStateId(offset + ((y & 0x0f) << 8)));
 
         // get light value from one block above
         int light;
@@ -110,201 +227,228 @@ void ChunkRenderer::renderChunk(QSharedPointer<Chunk> chunk) {
         if (!(this->flags & MapView::flgLighting))
           light = 13;
         // y gradient detection / edge highlight
-        if ((alpha == 0.0) && (lasty != -9999)) {
+        if (blend.isEmpty() && (lasty != -9999)) {
           if (lasty < y)
             light += 2;
           else if (lasty > y)
             light -= 2;
         }
-//        if (light < 0) light = 0;
-//        if (light > 15) light = 15;
+        light = std::clamp(light, 0, 15);
 
         // get Biome
+        qint32 biomeID = chunk->getBiomeID(x,y,z);
         const BiomeInfo &biome = (chunk->version >=2800) ?
-            BiomeIdentifier::Instance().getBiomeBySection(chunk->getBiomeID(x,y,z)) :
-            BiomeIdentifier::Instance().getBiomeByChunk  (chunk->getBiomeID(x,y,z));
-        // get current block color
-        QColor blockcolor = block.colors[15];  // get the color from Block definition
-        if (block.biomeWater()) {
-          blockcolor = biome.getBiomeWaterColor(blockcolor);
-        }
-        else if (block.biomeGrass()) {
-          blockcolor = biome.getBiomeGrassColor(blockcolor, y-64);
+            BiomeIdentifier::Instance().getBiomeBySection(biomeID) :
+            BiomeIdentifier::Instance().getBiomeByChunk  (biomeID);
+
+        // remember top Block for Biome colors
+        if (blend.isEmpty()) {
+          chunk->topBiome[offset] = biomeID;
+          chunk->topLight[offset] = light;
         }
-        else if (block.biomeFoliage()) {
-          blockcolor = biome.getBiomeFoliageColor(blockcolor, y-64);
+        if (block.alpha == 0) continue;  // only sampled for Biome in SingleLayer mode
+
+        // get current block color
+        QRgb blockcolor = block.color;  // get the color from Block definition
+        if (block.tint != BlockStateColor::TintNone) {
+          // consecutive Blocks mostly share Biome, Block and elevation
+          if ((&biome != lastTintBiome) || (blockcolor != lastTintBase) || (y != lastTintY)) {
+            lastTintBiome = &biome;
+            lastTintBase  = blockcolor;
+            lastTintY     = y;
+            lastTintColor = tints.getColor(biome, block, y-64);
+          }
+          blockcolor = lastTintColor;
         }
 
         // shade color based on light value
-        double light_factor = precomputed_light_factors[light];
-        quint32 colr = std::clamp( int(light_factor*blockcolor.red()),   0, 255 );
-        quint32 colg = std::clamp( int(light_factor*blockcolor.green()), 0, 255 );
-        quint32 colb = std::clamp( int(light_factor*blockcolor.blue()),  0, 255 );
-
-        if (this->flags & MapView::flgDepthShading) {
-          // Use a table to define depth-relative shade:
-          static const quint32 shadeTable[] = {
-            0, 12, 18, 22, 24, 26, 28, 29, 30, 31, 32};
-          size_t idx = std::min(static_cast<size_t>(this->depth - y),
-                            sizeof(shadeTable) / sizeof(*shadeTable) - 1);
-          quint32 shade = shadeTable[idx];
-          colr = colr - std::min(shade, colr);
-          colg = colg - std::min(shade, colg);
-          colb = colb - std::min(shade, colb);
-        }
+        const auto &lightShade = lightMultiply[light];
+        quint32 colr = lightShade[qRed(blockcolor)];
+        quint32 colg = lightShade[qGreen(blockcolor)];
+        quint32 colb = lightShade[qBlue(blockcolor)];
+
+        // depth-relative shade (applied in overlay pass)
+        size_t shadeIdx = std::min(static_cast<size_t>(this->depth - y),
+                                   sizeof(shadeTable) / sizeof(*shadeTable) - 1);
+        quint32 shade = shadeTable[shadeIdx];
 
         if (this->flags & MapView::flgMobSpawn) {
-          // get block info from 1 and 2 above and 1 below
-          uint blid1(0), blid2(0), blidB(0);  // default to legacy air (todo: better handling of block above)
-          const ChunkSection *section2 = chunk->getSectionByY(y+2);
-          const ChunkSection *sectionB = chunk->getSectionByY(y-1);
-          if (section1) {
-            blid1 = section1->getPaletteEntry(offset, y+1).hid;
-          }
-          if (section2) {
-            blid2 = section2->getPaletteEntry(offset, y+2).hid;
-          }
-          if (sectionB) {
-            blidB = sectionB->getPaletteEntry(offset, y-1).hid;
-          }
-          const BlockInfo &block2 = BlockIdentifier::Instance().getBlockInfo(blid2);
-          const BlockInfo &block1 = BlockIdentifier::Instance().getBlockInfo(blid1);
-          const BlockInfo &block0 = block;
-          const BlockInfo &blockB = BlockIdentifier::Instance().getBlockInfo(blidB);
-          int light0 = section->getBlockLight(offset, y);
+          // spawn rules evaluated on the column masks of Blocks y-1 .. y+2
+          SpawnWindow w(*chunk, offset, y);
+          const quint32 ground = w.bits[ChunkSection::mskSolidTop] & ~w.bits[ChunkSection::mskBedrock];
+          const quint32 fits   = w.bits[ChunkSection::mskSpawnInside] & ~w.bits[ChunkSection::mskNormalCube];
+          const quint32 dry    = ~w.bits[ChunkSection::mskLiquid];
+          // bit 0: standing in y on y-1, bit 1: standing in y+1 on y
+          const quint32 spawn  = ground & ((fits & dry) >> 1) & (fits >> 2);
+          int light0 = -1;  // read only when needed
 
            // spawn check #1: on top of solid block
-           if (block0.doesBlockHaveSolidTopSurface() &&
-               !block0.isBedrock() && light1 < lightSpawnSave &&
-               !block1.isBlockNormalCube() && block1.spawninside &&
-               !block1.isLiquid() &&
-               !block2.isBlockNormalCube() && block2.spawninside) {
+           if ((spawn & 2) && (light1 < lightSpawnSave)) {
              colr = (colr + 256) / 2;
              colg = (colg + 0) / 2;
              colb = (colb + 192) / 2;
            }
            // spawn check #2: current block is transparent,
            // but mob can spawn through from block below (e.g. snow)
-           if (blockB.doesBlockHaveSolidTopSurface() &&
-               !blockB.isBedrock() && light0 < lightSpawnSave &&
-               !block0.isBlockNormalCube() && block0.spawninside &&
-               !block0.isLiquid() &&
-               !block1.isBlockNormalCube() && block1.spawninside) {
-             colr = (colr + 192) / 2;
-             colg = (colg + 0) / 2;
-             colb = (colb + 256) / 2;
+           if (spawn & 1) {
+             light0 = section->getBlockLight(offset, y);
+             if (light0 < lightSpawnSave) {
+               colr = (colr + 192) / 2;
+               colg = (colg + 0) / 2;
+               colb = (colb + 256) / 2;
+             }
            }
            // water spawn check for Drowned, introduced with "Update Aquatic" (1.13)
            if ((chunk->version >= 1478) &&
-               ((biome.isOceanBiome() && (y < 58)) || biome.isRiverBiome()) &&
-               (light0 < lightSpawnSave) &&
-               block0.biomeWater() &&
-               block1.biomeWater() ) {
-             colr = (colr + 256) / 2;
-             colg = (colg + 0) / 2;
-             colb = (colb + 128) / 2;
+               ((biome.isOceanBiome() && (y < 58)) || biome.isRiverBiome())) {
+             if (light0 < 0)
+               light0 = section->getBlockLight(offset, y);
+             if ((light0 < lightSpawnSave) && isBiomeWater(*chunk, offset, y) && isBiomeWater(*chunk, offset, y+1)) {
+               colr = (colr + 256) / 2;
+               colg = (colg + 0) / 2;
+               colb = (colb + 128) / 2;
+             }
            }
         }
 
-        if (this->flags & MapView::flgBiomeColors) {
-          colr = biome.colors[light].red();
-          colg = biome.colors[light].green();
-          colb = biome.colors[light].blue();
-        }
-
-        if (isSlimeChunk) {
-          colg = (colg + 255) / 2;
-        }
-
-        if (this->flags & MapView::flgInhabitedTime) {
-          // first reduce brightness
-          colr = colr / 2;
-          colg = colg / 2;
-          colb = colb / 2;
-          // then add highlight
-          int rdidx = static_cast<int>(regionalDifficulty);
-          double rd = regionalDifficulty - rdidx;
-          switch (rdidx) {
-          case 0:  // transparent -> blue
-            colb = (colb + 255*regionalDifficulty) / 2;
-            break;
-          case 1:  // blue -> cyan
-            colg = (colg + 255*rd) / 2;
-            colb = (colb + 255) / 2;
-            break;
-          case 2:  // cyan -> green
-            colg = (colg + 255) / 2;
-            colb = (colb + 255*(1.0-rd)) / 2;
-            break;
-          case 3:  // green -> yellow
-            colr = (colr + 255*rd) / 2;
-            colg = (colg + 255) / 2;
-            break;
-          case 4:  // yellow -> red
-            colr = (colr + 255) / 2;
-            colg = (colg + 255*(1.0-rd)) / 2;
-            break;
-          case 5:  // red -> purple
-            colr = (colr + 255) / 2;
-            colb = (colb + 255*rd) / 2;
-            break;
-          default:  // saturated at purple
-            colr = (colr + 255) / 2;
-            colb = (colb + 255) / 2;
-          }
-        }
-
         // combine current block to final color
-        if (alpha == 0.0) {
-          // first color sample
-          alpha = block.alpha;
-          r = colr;
-          g = colg;
-          b = colb;
+        samples++;
+        if (blend.isEmpty())
           highest = y;
-        } else {
-          // combine further color samples with blending
-          r = (quint8)(alpha * r + (1.0 - alpha) * colr);
-          g = (quint8)(alpha * g + (1.0 - alpha) * colg);
-          b = (quint8)(alpha * b + (1.0 - alpha) * colb);
-          alpha += block.alpha * (1.0 - alpha);
-        }
-
         // finish depth (Y) scanning when color is saturated enough
-        if (block.alpha == 1.0 || alpha > 0.9)
+        if (blend.add(colr, colg, colb, shade, block.alpha))
           break;
 
       } // top -> down
 
       // finished to find color for current column, only continue for cave mode
-      if (this->flags & MapView::flgCaveMode) {
-        float cave_factor = 1.0;
-        int cave_test = 0;
-        for (int y=highest-1; (y >= stopY) && (cave_test < CaveShade::CAVE_DEPTH); y--, cave_test++) {  // top->down
-          // get section
-          const ChunkSection *section = chunk->getSectionByY(y);
-          if (!section) continue;
-          // get BlockInfo from block value
-          const BlockInfo &block = BlockIdentifier::Instance().getBlockInfo(section->getPaletteEntry(offset, y).hid);
-          if (block.transparent) {
-            cave_factor -= CaveShade::getShade(cave_test);
-          }
-        }
-        cave_factor = std::max(cave_factor, 0.25f);
-        // darken color by blending with cave shade factor
-        r = (quint8)(cave_factor * r);
-        g = (quint8)(cave_factor * g);
-        b = (quint8)(cave_factor * b);
+      chunk->baseShade[offset]   = blend.shade();
+      chunk->baseSamples[offset] = std::min(samples, 255);
+      chunk->baseCave[offset]  = 255;
+      if ((this->flags & MapView::flgCaveMode) && (highest > stopY)) {
+        // transparent Blocks in the CAVE_DEPTH Blocks below the top one (bit 15 = directly below)
+        const int lowY = highest - CaveShade::CAVE_DEPTH;
+        const int sec  = lowY >> 4;
+        quint32 column = 0;
+        if (const ChunkSection *lower = chunk->getSectionByIdx(sec))
+          column  = lower->getColumnMask(ChunkSection::mskTransparent, offset);
+        if (const ChunkSection *upper = chunk->getSectionByIdx(sec + 1))
+          column |= quint32(upper->getColumnMask(ChunkSection::mskTransparent, offset)) << 16;
+        quint16 mask = quint16(column >> (lowY & 0x0f));
+        if (lowY < stopY)
+          mask &= quint16(0xffff << (stopY - lowY));
+        float cave_factor = std::max(1.0f - CaveShade::getMaskShade(mask), 0.25f);
+        // darken color by blending with cave shade factor (applied in overlay pass)
+        chunk->baseCave[offset] = quint8(qRound(cave_factor * 255));
       }
 
       *depthbits++ = lasty = highest;
-      *bits++ = b;
-      *bits++ = g;
-      *bits++ = r;
+      *bits++ = blend.b;
+      *bits++ = blend.g;
+      *bits++ = blend.r;
       *bits++ = 0xff;
     }
   }
   chunk->renderedAt = this->depth;
+  chunk->renderedFlags = this->flags & ~overlayFlags;
+}
+
+
+// overlay pass: apply view flags, that only modify the column colors of the base pass
+void ChunkRenderer::renderOverlays(QSharedPointer<Chunk> chunk) {
+  bool isSlimeChunk = false;
+  if (this->flags & MapView::flgSlimeChunks) {
+    long long seed =
+        ( WorldInfo::Instance().getSeed() +
+          (int) (cx * cx * 0x4c1906) +
+          (int) (cx * 0x5ac0db) +
+          (int) (cz * cz) * 0x4307a7LL +
+          (int) (cz * 0x5f24f) ^ 0x3ad8025fLL );
+    if (Java::Random(seed).nextInt(10) == 0)
+      isSlimeChunk = true;
+  }
+
+  float regionalDifficulty = 0.0;
+  if (this->flags & MapView::flgInhabitedTime) {
+    // regional difficulty is max-capped at 3600000 ticks
+    long long inhabitedTime = std::min<long long>(chunk->inhabitedTime, 3600000);
+    regionalDifficulty = 6.0 * static_cast<double>(inhabitedTime) / 3600000.0;
+  }
+
+  const uchar *src = chunk->baseImage;
+  uchar       *dst = chunk->image;
+  for (int offset = 0; offset < 16*16; offset++, src += 4, dst += 4) {
+    quint32 colb = src[0];
+    quint32 colg = src[1];
+    quint32 colr = src[2];
+
+    if (this->flags & MapView::flgBiomeColors) {
+      // flat Biome color of top Block, columns without any Block stay black
+      if (chunk->topBiome[offset] != Chunk::noBiome) {
+        const BiomeInfo &biome = (chunk->version >=2800) ?
+            BiomeIdentifier::Instance().getBiomeBySection(chunk->topBiome[offset]) :
+            BiomeIdentifier::Instance().getBiomeByChunk  (chunk->topBiome[offset]);
+        int light = chunk->topLight[offset];
+        colr = biome.colors[light].red();
+        colg = biome.colors[light].green();
+        colb = biome.colors[light].blue();
+      }
+    } else if (this->flags & MapView::flgDepthShading) {
+      quint32 shade = chunk->baseShade[offset];
+      colr = colr - std::min(shade, colr);
+      colg = colg - std::min(shade, colg);
+      colb = colb - std::min(shade, colb);
+    }
+
+    if (isSlimeChunk) {
+      colg = (colg + 255) / 2;
+    }
+
+    if (this->flags & MapView::flgInhabitedTime) {
+      // first reduce brightness
+      colr = colr / 2;
+      colg = colg / 2;
+      colb = colb / 2;
+      // then add highlight
+      int rdidx = static_cast<int>(regionalDifficulty);
+      double rd = regionalDifficulty - rdidx;
+      switch (rdidx) {
+      case 0:  // transparent -> blue
+        colb = (colb + 255*regionalDifficulty) / 2;
+        break;
+      case 1:  // blue -> cyan
+        colg = (colg + 255*rd) / 2;
+        colb = (colb + 255) / 2;
+        break;
+      case 2:  // cyan -> green
+        colg = (colg + 255) / 2;
+        colb = (colb + 255*(1.0-rd)) / 2;
+        break;
+      case 3:  // green -> yellow
+        colr = (colr + 255*rd) / 2;
+        colg = (colg + 255) / 2;
+        break;
+      case 4:  // yellow -> red
+        colr = (colr + 255) / 2;
+        colg = (colg + 255*(1.0-rd)) / 2;
+        break;
+      case 5:  // red -> purple
+        colr = (colr + 255) / 2;
+        colb = (colb + 255*rd) / 2;
+        break;
+      default:  // saturated at purple
+        colr = (colr + 255) / 2;
+        colb = (colb + 255) / 2;
+      }
+    }
+
+    // cave mode darkening is done last
+    quint32 cave = chunk->baseCave[offset];
+    dst[0] = quint8(colb * cave / 255);
+    dst[1] = quint8(colg * cave / 255);
+    dst[2] = quint8(colr * cave / 255);
+    dst[3] = 0xff;
+  }
   chunk->renderedFlags = this->flags;
 }
 
@@ -322,9 +466,80 @@ CaveShade::CaveShade()
   for (int i=0; i<CAVE_DEPTH; i++) {
     caveshade[i] = 1.5 * caveshade[i] / cavesum;
   }
+  // lookup tables to sum the shades of a whole column mask with two reads
+  static_assert(CAVE_DEPTH == 16, "column masks have 16 bits");
+  for (int half = 0; half < 2; half++) {
+    for (int bits = 0; bits < 256; bits++) {
+      float sum = 0.0;
+      for (int b = 0; b < 8; b++)
+        if (bits & (1 << b))
+          sum += caveshade[CAVE_DEPTH - 1 - (half * 8 + b)];
+      maskshade[half][bits] = sum;
+    }
+  }
 }
 
-float CaveShade::getShade(int index) {
+const CaveShade &CaveShade::Instance() {
   static CaveShade singleton;
-  return singleton.caveshade[index];
+  return singleton;
+}
+
+float CaveShade::getShade(int index) {
+  return Instance().caveshade[index];
+}
+
+float CaveShade::getMaskShade(quint16 mask) {
+  const CaveShade &shade = Instance();
+  return shade.maskshade[0][mask & 0xff] + shade.maskshade[1][mask >> 8];
+}
+
+
+// memo of Biome dependent colors
+
+BiomeTintCache &BiomeTintCache::Instance() {
+  static BiomeTintCache singleton;
+  return singleton;
+}
+
+uint qHash(const BiomeTintCache::Key &key, uint seed) {
+  return qHash(quintptr(key.biome), seed) ^ qHash(key.color, seed) ^
+         qHash((key.elevation << 2) | key.tint, seed);
+}
+
+QRgb BiomeTintCache::getColor(const BiomeInfo &biome, const BlockStateColor &state, int elevation) {
+  // water color does not depend on elevation
+  Key key = { &biome, state.color, state.tint,
+              (state.tint == BlockStateColor::TintWater) ? 0 : elevation };
+  {
+    QReadLocker locker(&lock);
+    auto it = colors.constFind(key);
+    if (it != colors.constEnd())
+      return it.value();
+  }
+
+  QColor blockcolor = QColor::fromRgb(state.color);
+  switch (state.tint) {
+    case BlockStateColor::TintWater:
+      blockcolor = biome.getBiomeWaterColor(blockcolor);
+      break;
+    case BlockStateColor::TintGrass:
+      blockcolor = biome.getBiomeGrassColor(blockcolor, elevation);
+      break;
+    case BlockStateColor::TintFoliage:
+      blockcolor = biome.getBiomeFoliageColor(blockcolor, elevation);
+      break;
+    default:
+      break;
+  }
+
+  QWriteLocker locker(&lock);
+  if (colors.size() >= MAX_ENTRIES)
+    colors.clear();  // should never happen, but keep memory bounded
+  colors.insert(key, blockcolor.rgb());
+  return blockcolor.rgb();
+}
+
+void BiomeTintCache::clear() {
+  QWriteLocker locker(&lock);
+  colors.clear();
 }
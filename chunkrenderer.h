@@ -3,26 +3,40 @@
 #define CHUNKRENDERER_H
 
 #include <QObject>
+#include <QReadWriteLock>
 #include <QRunnable>
 #include "chunkcache.h"
+#include "identifier/blockstateregistry.h"
+
+class BiomeInfo;
 
 class ChunkRenderer : public QObject, public QRunnable {
   Q_OBJECT
 
  public:
-  ChunkRenderer(int cx, int cz, int y, int flags);
+  ChunkRenderer(int cx, int cz, int y, int flags);                 // single Chunk
+  ChunkRenderer(const QList<ChunkID> &chunks, int y, int flags);   // batch of Chunks
   ~ChunkRenderer() {}
 
+  // edge length of the Chunk tiles rendered as one batch
+  static const int BATCH_SIZE = 4;
+
  protected:
   void run();
 
  public:  // public to allow usage from WorldSave
-  void renderChunk(QSharedPointer<Chunk> chunk);
+  void renderChunk(QSharedPointer<Chunk> chunk);     // base pass + overlay pass
+  void renderBase(QSharedPointer<Chunk> chunk);      // scan Blocks
+  void renderOverlays(QSharedPointer<Chunk> chunk);  // apply overlayFlags to base pass results
+
+  // view flags handled by renderOverlays() only
+  static const int overlayFlags;
 
  signals:
-  void rendered(int cx, int cz);
+  void rendered(const QList<ChunkID> &chunks);  // once per batch
 
  private:
+  QList<ChunkID> chunks;
   int cx, cz;
   int depth;
   int flags;
@@ -33,16 +47,54 @@ class CaveShade {
  public:
   // singleton: access to global usable instance
   static float getShade(int index);
+  // summed shade of all set bits, bit 15 is index 0 (Block directly below the top)
+  static float getMaskShade(quint16 mask);
  private:
   // singleton: prevent access to constructor and copyconstructor
   CaveShade();
   ~CaveShade() {}
   CaveShade(const CaveShade &);
   CaveShade &operator=(const CaveShade &);
+  static const CaveShade &Instance();
 
  public:
   static const int CAVE_DEPTH = 16;  // maximum depth caves are searched in cave mode
   float caveshade[CAVE_DEPTH];
+  float maskshade[2][256];           // [low, high byte][bits] summed shade
+};
+
+// Memo of Biome dependent Block colors (grass, foliage, water),
+// as the HSL based color mixing is too expensive to do for each Block.
+class BiomeTintCache {
+ public:
+  // singleton: access to global usable instance
+  static BiomeTintCache &Instance();
+
+  QRgb getColor(const BiomeInfo &biome, const BlockStateColor &state, int elevation);
+  void clear();  // needed when Biome or Block definitions change
+
+ private:
+  // singleton: prevent access to constructor and copyconstructor
+  BiomeTintCache() {}
+  ~BiomeTintCache() {}
+  BiomeTintCache(const BiomeTintCache &);
+  BiomeTintCache &operator=(const BiomeTintCache &);
+
+  struct Key {
+    const BiomeInfo *biome;
+    QRgb             color;
+    int              tint;
+    int              elevation;
+    bool operator==(const Key &other) const {
+      return (biome == other.biome) && (color == other.color) &&
+             (tint == other.tint) && (elevation == other.elevation);
+    }
+  };
+  friend uint qHash(const Key &key, uint seed);
+
+  static const int MAX_ENTRIES = 1 << 16;
+  QReadWriteLock   lock;
+  QHash<Key, QRgb> colors;
 };
 
 #endif // CHUNKRENDERER_H
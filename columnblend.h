@@ -0,0 +1,56 @@
+/** Copyright (c) 2026, EtlamGit */
+#ifndef COLUMNBLEND_H_
+#define COLUMNBLEND_H_
+
+#include <QtGlobal>
+
+// Blends the Block colors of one column top->down with fixed point alpha.
+// Alpha has 15 fractional bits and is rounded while accumulating,
+// so results stay within +-1 of the former floating point blending.
+class ColumnBlend {
+ public:
+  static const int ALPHA_ONE = 1 << 15;  // opaque
+
+  // alpha of Block definitions (0.0 .. 1.0) in fixed point,
+  // rounded down, so stacks reaching exactly 0.9 stay below the cutoff like in floating point
+  static quint16 toFixed(double alpha) {
+    if (alpha <= 0.0) return 0;
+    if (alpha >= 1.0) return ALPHA_ONE;
+    return quint16(alpha * ALPHA_ONE);
+  }
+
+  ColumnBlend() : r(0), g(0), b(0), alpha(0), shade8(0) {}
+
+  bool    isEmpty() const { return alpha == 0; }
+  quint32 shade() const { return (shade8 + 128) >> 8; }
+
+  // add the next Block below (blockAlpha > 0),
+  // returns true when saturated and Blocks further down are not visible
+  bool add(quint32 colr, quint32 colg, quint32 colb, quint32 blockShade, int blockAlpha) {
+    if (alpha == 0) {
+      // first color sample
+      r = colr;
+      g = colg;
+      b = colb;
+      shade8 = blockShade << 8;
+      alpha = blockAlpha;
+    } else {
+      const int rest = ALPHA_ONE - alpha;
+      r = quint8((alpha * r + rest * colr) >> 15);
+      g = quint8((alpha * g + rest * colg) >> 15);
+      b = quint8((alpha * b + rest * colb) >> 15);
+      shade8 = (alpha * shade8 + rest * (blockShade << 8)) >> 15;
+      alpha += (blockAlpha * rest + ALPHA_ONE / 2) >> 15;
+    }
+    // saturated enough above 0.9 (exact, without rounding the threshold)
+    return (blockAlpha == ALPHA_ONE) || (alpha * 10 > ALPHA_ONE * 9);
+  }
+
+  quint8  r, g, b;
+  int     alpha;  // ALPHA_ONE == opaque
+
+ private:
+  quint32 shade8;  // 8 fractional bits, small values would lose too much by truncation
+};
+
+#endif  // COLUMNBLEND_H_
@@ -0,0 +1,228 @@
+/** Copyright (c) 2026, EtlamGit */
+
+#include <QStringList>
+#include <algorithm>
+
+#include "blockstateregistry.h"
+#include "blockidentifier.h"
+#include "flatteningconverter.h"
+#include "columnblend.h"
+#include "nbt/tag.h"
+
+
+BlockStateRegistry::BlockStateRegistry()
+  : count(0)
+{
+  for (int i = 0; i < MAX_PAGES; i++) {
+    pages[i].storeRelease(nullptr);
+    colorPages[i].storeRelease(nullptr);
+  }
+
+  // state 0 is always plain air, used for empty or missing Sections
+  PaletteEntry air;
+  air.name = "minecraft:air";
+  air.hid  = qHash(air.name);
+  addState(air.name, air, true);
+}
+
+BlockStateRegistry::~BlockStateRegistry() {
+  for (int i = 0; i < MAX_PAGES; i++) {
+    delete[] pages[i].loadAcquire();
+    delete[] colorPages[i].loadAcquire();
+  }
+  for (PaletteEntry *page : retiredPages)
+    delete[] page;
+  for (BlockStateColor *page : retiredColorPages)
+    delete[] page;
+}
+
+BlockStateRegistry& BlockStateRegistry::Instance() {
+  static BlockStateRegistry singleton;
+  return singleton;
+}
+
+int BlockStateRegistry::getStateCount() const {
+  return count.loadAcquire();
+}
+
+void BlockStateRegistry::updateDefinitions() {
+  QWriteLocker locker(&lock);
+  BlockIdentifier &bi = BlockIdentifier::Instance();
+  const PaletteEntry *converter = FlatteningConverter::Instance().getPalette();
+  int states = count.loadAcquire();
+  for (int page = 0; page * PAGE_SIZE < states; page++) {
+    // render threads may read the old page at any time:
+    // resolve into a copy and publish it at once
+    PaletteEntry *oldPage = pages[page].loadAcquire();
+    PaletteEntry *newPage = new PaletteEntry[PAGE_SIZE];
+    std::copy(oldPage, oldPage + PAGE_SIZE, newPage);
+    BlockStateColor *oldColors = colorPages[page].loadAcquire();
+    BlockStateColor *newColors = new BlockStateColor[PAGE_SIZE];
+    std::copy(oldColors, oldColors + PAGE_SIZE, newColors);
+    for (int i = 0; i < PAGE_SIZE && page * PAGE_SIZE + i < states; i++) {
+      int id = page * PAGE_SIZE + i;
+      if (resolved.testBit(id)) {
+        newPage[i].hid = resolveHid(newPage[i]);
+      } else if (newPage[i].properties.contains(PaletteEntry::legacyBlockIdProperty)) {
+        // legacy states are mapped again by FlatteningConverter
+        QString oldKey = legacyKey(newPage[i]);
+        if (ids.value(oldKey) == quint32(id))
+          ids.remove(oldKey);
+        int vid = newPage[i].properties[PaletteEntry::legacyBlockIdProperty].toInt();
+        if ((vid >= 0) && (vid < FlatteningConverter::paletteLength))
+          newPage[i] = converter[vid];
+        QString key = legacyKey(newPage[i]);
+        if (!ids.contains(key))
+          ids.insert(key, id);
+      }
+      newColors[i] = resolveColor(bi.getBlockInfo(newPage[i].hid));
+    }
+    pages[page].storeRelease(newPage);
+    colorPages[page].storeRelease(newColors);
+    // references to old entries may still be in use
+    retiredPages.append(oldPage);
+    retiredColorPages.append(oldColors);
+  }
+}
+
+void BlockStateRegistry::releaseRetiredPages() {
+  QWriteLocker locker(&lock);
+  for (PaletteEntry *page : retiredPages)
+    delete[] page;
+  retiredPages.clear();
+  for (BlockStateColor *page : retiredColorPages)
+    delete[] page;
+  retiredColorPages.clear();
+}
+
+
+quint32 BlockStateRegistry::getStateId(const QString &name, const Tag *properties) {
+  // build a unique key with properties in sorted order
+  QString key = name;
+  QStringList propertyKeys;
+  if (properties) {
+    propertyKeys = properties->keys();
+    propertyKeys.sort();
+    if (!propertyKeys.isEmpty()) {
+      QStringList pairs;
+      for (const auto &pkey : propertyKeys)
+        pairs << pkey + "=" + properties->at(pkey)->toString();
+      key += "[" + pairs.join(",") + "]";
+    }
+  }
+
+  quint32 id = lookup(key);
+  if (id != quint32(-1))
+    return id;
+
+  // new state: decode everything only once
+  PaletteEntry entry;
+  entry.name = name;
+  if (!propertyKeys.isEmpty())
+    entry.properties = properties->getData().toMap();
+  entry.hid = resolveHid(entry);
+  return addState(key, entry, true);
+}
+
+quint32 BlockStateRegistry::getStateId(const PaletteEntry &entry) {
+  QString key = legacyKey(entry);
+  quint32 id = lookup(key);
+  if (id != quint32(-1))
+    return id;
+  return addState(key, entry, false);
+}
+
+// legacy entries are already resolved, their hid is part of the identity
+QString BlockStateRegistry::legacyKey(const PaletteEntry &entry) {
+  QString key = entry.name;
+  if (!entry.properties.isEmpty()) {
+    QStringList pairs;
+    for (auto it = entry.properties.constBegin(); it != entry.properties.constEnd(); ++it)
+      pairs << it.key() + "=" + it.value().toString();
+    key += "[" + pairs.join(",") + "]";
+  }
+  return key + "#" + QString::number(entry.hid);
+}
+
+
+quint32 BlockStateRegistry::lookup(const QString &key) const {
+  QReadLocker locker(&lock);
+  return ids.value(key, quint32(-1));
+}
+
+quint32 BlockStateRegistry::addState(const QString &key, const PaletteEntry &entry, bool resolve) {
+  QWriteLocker locker(&lock);
+  // some other thread may have added it in the meantime
+  auto it = ids.constFind(key);
+  if (it != ids.constEnd())
+    return it.value();
+
+  int id = count.loadAcquire();
+  int page = id >> PAGE_BITS;
+  if (page >= MAX_PAGES) {
+    // registry is full: map everything else to air
+    return AIR;
+  }
+  if (pages[page].loadAcquire() == nullptr) {
+    pages[page].storeRelease(new PaletteEntry[PAGE_SIZE]);
+    colorPages[page].storeRelease(new BlockStateColor[PAGE_SIZE]);
+  }
+  pages[page].loadAcquire()[id & PAGE_MASK] = entry;
+  colorPages[page].loadAcquire()[id & PAGE_MASK] = resolveColor(BlockIdentifier::Instance().getBlockInfo(entry.hid));
+  ids.insert(key, id);
+  if (resolved.size() <= id)
+    resolved.resize(std::max(PAGE_SIZE, 2 * resolved.size()));
+  resolved.setBit(id, resolve);
+  count.storeRelease(id + 1);
+  return id;
+}
+
+
+// find hid of a matching variant in the Block definitions
+// called only once per state (and after definition changes)
+uint BlockStateRegistry::resolveHid(const PaletteEntry &entry) {
+  BlockIdentifier &bi = BlockIdentifier::Instance();
+  uint hid = qHash(entry.name);
+
+  BlockInfo const & block = bi.getBlockInfo(hid);
+  if (!block.hasVariants())
+    return hid;
+
+  // "key:value" for all available properties
+  QStringList properties;
+  for (auto it = entry.properties.constBegin(); it != entry.properties.constEnd(); ++it)
+    properties << it.key() + ":" + it.value().toString();
+
+  // test all available properties
+  for (const auto &property : properties) {
+    uint vhid = qHash(entry.name + ":" + property);
+    if (bi.hasBlockInfo(vhid))
+      hid = vhid;  // use this vaiant instead
+  }
+  // test all possible combinations of 2 combined properties
+  for (const auto &property1 : properties) {
+    for (const auto &property2 : properties) {
+      if (&property1 == &property2) continue;
+      uint vhid = qHash(entry.name + ":" + property1 + " " + property2);
+      if (bi.hasBlockInfo(vhid))
+        hid = vhid;  // use this vaiant instead
+    }
+  }
+  return hid;
+}
+
+
+BlockStateColor BlockStateRegistry::resolveColor(const BlockInfo &block) {
+  BlockStateColor state;
+  state.color = block.colors[15].rgb();
+  state.alpha = ColumnBlend::toFixed(block.alpha);
+  if (block.biomeWater())
+    state.tint = BlockStateColor::TintWater;
+  else if (block.biomeGrass())
+    state.tint = BlockStateColor::TintGrass;
+  else if (block.biomeFoliage())
+    state.tint = BlockStateColor::TintFoliage;
+  else
+    state.tint = BlockStateColor::TintNone;
+  return state;
+}
@@ -0,0 +1,101 @@
+/** Copyright (c) 2026, EtlamGit */
+#ifndef BLOCKSTATEREGISTRY_H_
+#define BLOCKSTATEREGISTRY_H_
+
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QBitArray>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QRgb>
+#include <QString>
+#include <QVector>
+
+#include "paletteentry.h"
+
+class Tag;
+class BlockInfo;
+
+
+// Everything needed to render a Block state, precomputed from its BlockInfo.
+class BlockStateColor {
+ public:
+  enum Tint : quint8 {
+    TintNone = 0,
+    TintWater,
+    TintGrass,
+    TintFoliage
+  };
+
+  QRgb    color;  // base color from Block definition
+  quint16 alpha;  // fixed point: 0 = invisible .. ColumnBlend::ALPHA_ONE = opaque
+  Tint    tint;   // Biome dependent color modification
+};
+
+
+// Global registry of all Block states (name + properties) seen in any Chunk.
+// Each distinct state is stored exactly once and identified by a compact ID,
+// Sections only store these IDs in their palette.
+// Lookup of an ID is lock free, adding new states is thread safe.
+class BlockStateRegistry {
+ public:
+  // singleton: access to global usable instance
+  static BlockStateRegistry &Instance();
+
+  // state ID for a Block from a Chunk palette, added when not yet known
+  quint32 getStateId(const QString &name, const Tag *properties);
+  // state ID for an already converted legacy Block
+  quint32 getStateId(const PaletteEntry &entry);
+
+  const PaletteEntry    &getPaletteEntry(quint32 stateId) const;
+  const BlockStateColor &getStateColor(quint32 stateId) const;
+  int getStateCount() const;
+
+  // resolve Block variants again after definition packs changed
+  void updateDefinitions();
+  // free pages replaced by updateDefinitions(),
+  // only allowed when no other thread can hold a reference into them
+  void releaseRetiredPages();
+
+  static const quint32 AIR = 0;  // state ID of plain minecraft:air
+
+ private:
+  // singleton: prevent access to constructor and copyconstructor
+  BlockStateRegistry();
+  ~BlockStateRegistry();
+  BlockStateRegistry(const BlockStateRegistry &);
+  BlockStateRegistry &operator=(const BlockStateRegistry &);
+
+  quint32 lookup(const QString &key) const;
+  quint32 addState(const QString &key, const PaletteEntry &entry, bool resolve);
+  static QString legacyKey(const PaletteEntry &entry);
+  static uint resolveHid(const PaletteEntry &entry);
+  static BlockStateColor resolveColor(const BlockInfo &block);
+
+  // states are stored in pages that never move, so readers need no lock,
+  // updated pages are published as a whole and old ones are kept until shutdown
+  static const int PAGE_BITS = 12;
+  static const int PAGE_SIZE = 1 << PAGE_BITS;
+  static const int PAGE_MASK = PAGE_SIZE - 1;
+  static const int MAX_PAGES = 1024;
+  QAtomicPointer<PaletteEntry> pages[MAX_PAGES];
+  QAtomicPointer<BlockStateColor> colorPages[MAX_PAGES];  // same layout as pages
+  QAtomicInt    count;
+
+  mutable QReadWriteLock  lock;  // protects ids and adding to pages
+  QHash<QString, quint32> ids;   // key "name[property=value,...]" -> state ID
+  QBitArray resolved;            // hid of this state was resolved by us (not legacy)
+  QVector<PaletteEntry*>    retiredPages;       // replaced by updateDefinitions()
+  QVector<BlockStateColor*> retiredColorPages;
+};
+
+
+inline const PaletteEntry &BlockStateRegistry::getPaletteEntry(quint32 stateId) const {
+  return pages[stateId >> PAGE_BITS].loadAcquire()[stateId & PAGE_MASK];
+}
+
+inline const BlockStateColor &BlockStateRegistry::getStateColor(quint32 stateId) const {
+  return colorPages[stateId >> PAGE_BITS].loadAcquire()[stateId & PAGE_MASK];
+}
+
+#endif  // BLOCKSTATEREGISTRY_H_
@@ -18,10 +18,12 @@
 #include "definitionmanager.h"
 #include "biomeidentifier.h"
 #include "blockidentifier.h"
+#include "blockstateregistry.h"
 #include "dimensionidentifier.h"
 #include "entityidentifier.h"
 #include "flatteningconverter.h"
 #include "mapview.h"
+#include "chunkrenderer.h"
 #include "zipreader.h"
 #include "definitionupdater.h"
 
@@ -115,6 +117,13 @@ DefinitionManager::DefinitionManager(QWidget *parent) :
   // hook up table selection signal
   connect(table, &QTableWidget::currentItemChanged,
           this,  &DefinitionManager::selectedPack );
+  // Block variants and colors may resolve differently with changed packs
+  // (connected first, so it is done before anybody redraws)
+  connect(this, &DefinitionManager::packsChanged,
+          this, [] {
+            BlockStateRegistry::Instance().updateDefinitions();
+            BiomeTintCache::Instance().clear();
+          });
   // fill out table
   refresh();
 }
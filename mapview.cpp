@@ -2,12 +2,17 @@
 #include <QPainter>
 #include <QResizeEvent>
 #include <QMessageBox>
+#include <QElapsedTimer>
+#include <QTimer>
 #include <cmath>
 #include <assert.h>
 
 #include "mapview.h"
 #include "chunkcache.h"
+#include "blitter.h"
 #include "chunkrenderer.h"
+#include "tilepyramid.h"
+#include "regionoverview.h"
 #include "identifier/definitionmanager.h"
 #include "identifier/blockidentifier.h"
 #include "identifier/biomeidentifier.h"
@@ -18,11 +23,25 @@ MapView::MapView(QWidget *parent)
   , depth(255)
   , scale(1)      // overworld coordinate mapping
   , zoomLevel(0)  // 1:1
+  , flags(0)
   , cache(ChunkCache::Instance())
 {
   adjustZoom(0, false, false);
   connect(&cache, &ChunkCache::chunkLoaded,
           this,   &MapView::chunkUpdated);
+  connect(&cache, &ChunkCache::entitiesLoaded,
+          this,   &MapView::entitiesUpdated);
+  qRegisterMetaType<QList<ChunkID>>("QList<ChunkID>");
+  connect(&TilePyramid::Instance(), &TilePyramid::tileReady,
+          this,                     &MapView::tileReady);
+  connect(&RegionOverview::Instance(), &RegionOverview::scanned,
+          this,                        &MapView::overviewScanned);
+
+  // at most one redraw per display frame
+  redrawTimer.setSingleShot(true);
+  redrawTimer.setInterval(16);
+  connect(&redrawTimer, &QTimer::timeout,
+          this,         &MapView::redraw);
 
   setMouseTracking(true);
   setFocusPolicy(Qt::StrongFocus);
@@ -56,8 +75,9 @@ QSize MapView::sizeHint() const {
 
 void MapView::attach(DefinitionManager *dm) {
   this->dm = dm;
+  // cached Chunks have Block attributes from old definitions -> reload
   connect(dm, SIGNAL(packsChanged()),
-          this, SLOT(redraw()));
+          this, SLOT(clearCache()));
 }
 
 void MapView::setLocation(double x, double z) {
@@ -97,18 +117,22 @@ void MapView::setDimension(QString path, int scale) {
     this->z = 0;
   }
   clearOverlayItems();
+  drawnValid = false;
   cache.clear();
   cache.setPath(path);
+  TilePyramid::Instance().setPath(path);
+  RegionOverview::Instance().setPath(path);
   redraw();
 }
 
 void MapView::setDepth(int depth) {
   this->depth = depth;
-  redraw();
+  scheduleRedraw();
 }
 
 void MapView::setFlags(int flags) {
   this->flags = flags;
+  updateEntitiesNeeded();
 }
 
 int MapView::getFlags() const {
@@ -124,16 +148,36 @@ void MapView::chunkUpdated(int x, int z) {
   update();
 }
 
+void MapView::entitiesUpdated(int x, int z) {
+  drawChunk(x, z);  // ChunkLock state is stored as Entity
+  scheduleRedraw();
+}
+
+void MapView::chunksRendered(const QList<ChunkID> &chunks) {
+  for (const ChunkID &id : chunks) {
+    // keep the base pass results of cached Chunks (variants are only touched in GUI thread)
+    QSharedPointer<Chunk> chunk(cache.fetchCached(id.getX(), id.getZ()));
+    if (chunk && chunk->loaded && !chunk->rendering)
+      chunk->storeRenderVariant();
+    drawChunk(id.getX(), id.getZ());
+  }
+  update();
+}
+
 QString MapView::getWorldPath() {
   return cache.getPath();
 }
 
 void MapView::updateSearchResultPositions(const QVector<QSharedPointer<OverlayItem> > &searchResults)
 {
-  currentSearchResults = searchResults;
+  currentSearchResults.clear();
+  for (auto &item : searchResults)
+    currentSearchResults.append(item);
 }
 
 void MapView::clearCache() {
+  drawnValid = false;
+  TilePyramid::Instance().clear(true);  // before the ChunkCache, waits for builders
   cache.clear();
   redraw();
 }
@@ -149,7 +193,7 @@ void MapView::adjustZoom(double steps, bool allowZoomOut, bool cursorSource)
 
   // use Fibonacci numbers to get natural zoom behaviour
   const float zoomTable[] = {1, 2, 3, 5, 8, 13, 21, 34, 55, 89};
-  const int zoomMin = allowZoomOut ? -4 : 0;
+  const int zoomMin = allowZoomOut ? -TilePyramid::LOD_MAX : 0;
   const int zoomMax = (sizeof(zoomTable) / sizeof(float)) -1;
 
   // snap the zoom level to bounds when the user scrolls too far
@@ -180,7 +224,9 @@ void MapView::adjustZoom(double steps, bool allowZoomOut, bool cursorSource)
     int cx = (imageChunks.width() +ppc-1) / ppc;
     int cz = (imageChunks.height()+ppc-1) / ppc;
     chunks = cx * cz;
-    if ((1.2 * chunks) <= maxchunks)
+    if (zoomIndex <= -TilePyramid::LOD_MIN)
+      restrictZoom = false; // zoomed out views are drawn from TilePyramid without Chunks
+    else if ((1.2 * chunks) <= maxchunks)
       restrictZoom = false; // everything matches with a low margin of 20%
     else {
       // restrict zoom
@@ -191,7 +237,8 @@ void MapView::adjustZoom(double steps, bool allowZoomOut, bool cursorSource)
   } while (restrictZoom);
 
   // we try to set higher margin than above (100%)!
-  cache.setCacheMaxSize(2.0 * chunks);
+  if (zoomIndex > -TilePyramid::LOD_MIN)
+    cache.setCacheMaxSize(2.0 * chunks);
 
   // pan to keep cursor pixel in same location
   if (cursorSource && QSettings().value("zoomFollowsCursor", true).toBool()) {
@@ -205,7 +252,7 @@ void MapView::adjustZoom(double steps, bool allowZoomOut, bool cursorSource)
   }
 
   // no point in redrawing if the zoom level didn't change
-  if (steps != 0) redraw();
+  if (steps != 0) scheduleRedraw();
 }
 
 static bool dragging = false;
@@ -219,7 +266,7 @@ void MapView::mouseMoveEvent(QMouseEvent *event) {
   if (dragging) {
     x += (lastMouseX-event->x()) / zoom;
     z += (lastMouseY-event->y()) / zoom;
-    redraw();
+    scheduleRedraw();
   }
 
   lastMouseX = event->x();
@@ -312,32 +359,32 @@ void MapView::keyPressEvent(QKeyEvent *event) {
     case Qt::Key_Up:
     case Qt::Key_W:
       z -= stepSize / zoom;
-      redraw();
+      scheduleRedraw();
       break;
     case Qt::Key_Down:
     case Qt::Key_S:
       z += stepSize / zoom;
-      redraw();
+      scheduleRedraw();
       break;
     case Qt::Key_Left:
     case Qt::Key_A:
       x -= stepSize / zoom;
-      redraw();
+      scheduleRedraw();
       break;
     case Qt::Key_Right:
     case Qt::Key_D:
       x += stepSize / zoom;
-      redraw();
+      scheduleRedraw();
       break;
     case Qt::Key_PageUp:
     case Qt::Key_Q:
       adjustZoom(1, allowZoomOut, false);
-      redraw();
+      scheduleRedraw();
       break;
     case Qt::Key_PageDown:
     case Qt::Key_E:
       adjustZoom(-1, allowZoomOut, false);
-      redraw();
+      scheduleRedraw();
       break;
     case Qt::Key_Home:
     case Qt::Key_Plus:
@@ -369,9 +416,39 @@ void MapView::paintEvent(QPaintEvent * /* event */) {
   p.end();
 }
 
+// move image content by (dx,dy) pixels, uncovered pixels keep their old content
+static void scrollImage(QImage &image, int dx, int dy) {
+  const int bpp = 4;  // Format_RGB32
+  int w = image.width()  - abs(dx);
+  int h = image.height() - abs(dy);
+  if (w <= 0 || h <= 0) return;
+  int srcx = std::max(0, -dx) * bpp;
+  int dstx = std::max(0,  dx) * bpp;
+  if (dy > 0) {
+    for (int y = h - 1; y >= 0; y--)
+      memmove(image.scanLine(y + dy) + dstx, image.constScanLine(y) + srcx, w * bpp);
+  } else {
+    for (int y = 0; y < h; y++)
+      memmove(image.scanLine(y) + dstx, image.constScanLine(y - dy) + srcx, w * bpp);
+  }
+}
+
+void MapView::scheduleRedraw() {
+  // input is accumulated in the view state until the next frame
+  if (!redrawTimer.isActive())
+    redrawTimer.start();
+}
+
 void MapView::redraw() {
+  redrawTimer.stop();  // also fulfills a scheduled redraw
+#if defined(DEBUG) || defined(_DEBUG) || defined(QT_DEBUG)
+  QElapsedTimer frameTimer;
+  frameTimer.start();
+#endif
+
   if (!this->isEnabled()) {
     // blank
+    drawnValid = false;
     imageChunks.fill(palette().color(QPalette::Base));
     imageOverlays.fill(Qt::transparent);
     update();
@@ -395,9 +472,51 @@ void MapView::redraw() {
   int blockswide = imageChunks.width() / chunksize + 3;
   int blockstall = imageChunks.height() / chunksize + 3;
 
-  for (int cz = startz; cz < startz + blockstall; cz++)
-    for (int cx = startx; cx < startx + blockswide; cx++)
-      drawChunk(cx, cz);
+  // pixel exact scrolling: keep the still visible part of imageChunks
+  // and draw only the newly exposed strips
+  const QPoint origin = getPixelOrigin();
+  QRect kept;
+  if (drawnValid && (drawnZoom == zoom) && (drawnDepth == depth) &&
+      (drawnFlags == flags) && (drawnSize == imageChunks.size())) {
+    QPoint delta = drawnOrigin - origin;
+    kept = imageChunks.rect().translated(delta) & imageChunks.rect();
+    if (!kept.isEmpty())
+      scrollImage(imageChunks, delta.x(), delta.y());
+  }
+  drawnValid  = true;
+  drawnOrigin = origin;
+  drawnSize   = imageChunks.size();
+  drawnZoom   = zoom;
+  drawnDepth  = depth;
+  drawnFlags  = flags;
+
+  const int lod = getLodLevel();
+  if (lod > 0) {
+    // zoomed out: draw Region Tiles from TilePyramid, Chunks are not touched
+    TilePyramid::Instance().setView(depth, flags);
+    QPainter canvas(&imageChunks);
+    canvas.setClipRegion(QRegion(imageChunks.rect()).subtracted(kept));
+    canvas.fillRect(imageChunks.rect(), palette().color(QPalette::Base));
+    canvas.setClipping(false);
+    const int tilesize = 512 >> lod;
+    int rx1 = floor(origin.x() / double(tilesize));
+    int rz1 = floor(origin.y() / double(tilesize));
+    int rx2 = floor((origin.x() + imageChunks.width())  / double(tilesize));
+    int rz2 = floor((origin.y() + imageChunks.height()) / double(tilesize));
+    // Tiles are only built for visible Regions, nearest to the center first
+    TilePyramid::Instance().setVisibleRegions(QRect(QPoint(rx1, rz1), QPoint(rx2, rz2)));
+    for (int rz = rz1; rz <= rz2; rz++)
+      for (int rx = rx1; rx <= rx2; rx++)
+        if (!kept.contains(QRect(rx * tilesize - origin.x(), rz * tilesize - origin.y(), tilesize, tilesize)))
+          drawTile(rx, rz, lod, canvas);
+  } else {
+    TilePyramid::Instance().cancelBuilding();
+    const int chunkpixels = qRound(chunksize);
+    for (int cz = startz; cz < startz + blockstall; cz++)
+      for (int cx = startx; cx < startx + blockswide; cx++)
+        if (!kept.contains(QRect(cx * chunkpixels - origin.x(), cz * chunkpixels - origin.y(), chunkpixels, chunkpixels)))
+          drawChunk(cx, cz);
+  }
 
   // clear the overlay layer
   imageOverlays.fill(0);
@@ -411,33 +530,66 @@ void MapView::redraw() {
   double x2 = x + halfviewwidth;
   double z2 = z + halvviewheight;
 
-  // draw the entities
-  for (int cz = startz; cz < startz + blockstall; cz++) {
-    for (int cx = startx; cx < startx + blockswide; cx++) {
-      QSharedPointer<Chunk> chunk(cache.fetch(cx, cz));
-      if (chunk) {
-        // Entities from Chunks
-        for (auto &type : overlayItemTypes) {
-          auto range = chunk->entities.equal_range(type);
-          for (auto it = range.first; it != range.second; ++it) {
-            // don't show entities above our depth
-            int entityY = (*it)->midpoint().y;
-            // everything below the current block,
-            // but also inside the current block
-            if (entityY < depth + 1) {
-              int entityX = static_cast<int>((*it)->midpoint().x) & 0x0f;
-              int entityZ = static_cast<int>((*it)->midpoint().z) & 0x0f;
-              int index = entityX + (entityZ << 4);
-              int highY = chunk->depth[index];
-              if ( (entityY+10 >= highY) ||
-                   (entityY+10 >= depth) )
-                (*it)->draw(x1, z1, zoom, &canvas);
+  // draw the entities (not when zoomed out, as this would load all Chunks)
+  if (lod == 0) {
+    QVector<QSharedPointer<OverlayItem>> visible;  // shared, Chunks may leave the cache meanwhile
+    for (int cz = startz; cz < startz + blockstall; cz++) {
+      for (int cx = startx; cx < startx + blockswide; cx++) {
+        QSharedPointer<Chunk> chunk(cache.fetch(cx, cz));
+        if (chunk) {
+          // Entities of cached Chunks are loaded when first shown
+          if (!chunk->entitiesLoaded && cache.getEntitiesNeeded())
+            cache.fetchEntities(cx, cz);
+          // Entities from Chunks
+          for (auto &type : overlayItemTypes) {
+            auto range = chunk->entities.equal_range(type);
+            for (auto it = range.first; it != range.second; ++it) {
+              // don't show entities above our depth
+              int entityY = (*it)->midpoint().y;
+              // everything below the current block,
+              // but also inside the current block
+              if (entityY < depth + 1) {
+                int entityX = static_cast<int>((*it)->midpoint().x) & 0x0f;
+                int entityZ = static_cast<int>((*it)->midpoint().z) & 0x0f;
+                int index = entityX + (entityZ << 4);
+                int highY = chunk->depth[index];
+                if ( (entityY+10 >= highY) ||
+                     (entityY+10 >= depth) )
+                  visible.append(*it);
+              }
             }
           }
         }
+      }
+    }
 
+    // count entities per screen area, so crowding depends on the current zoom
+    const int gw = imageOverlays.width()  / ENTITY_GLYPH_AREA + 1;
+    const int gh = imageOverlays.height() / ENTITY_GLYPH_AREA + 1;
+    QVector<int> counts(gw * gh, 0);
+    QVector<int> cells(visible.size(), -1);
+    for (int i = 0; i < visible.size(); i++) {
+      OverlayItem::Point p = visible[i]->midpoint();
+      int gx = floor((p.x - x1) * zoom / ENTITY_GLYPH_AREA);
+      int gz = floor((p.z - z1) * zoom / ENTITY_GLYPH_AREA);
+      if ((gx >= 0) && (gx < gw) && (gz >= 0) && (gz < gh)) {
+        cells[i] = gx + gz * gw;
+        counts[cells[i]]++;
+      }
+    }
+
+    // single glyphs where they fit, crowded areas as density raster
+    QVector<QPointF> dense;  // screen positions of entities drawn as density raster
+    for (int i = 0; i < visible.size(); i++) {
+      if ((cells[i] >= 0) && (counts[cells[i]] > ENTITY_GLYPH_LIMIT)) {
+        OverlayItem::Point p = visible[i]->midpoint();
+        dense.append(QPointF((p.x - x1) * zoom, (p.z - z1) * zoom));
+      } else {
+        visible[i]->draw(x1, z1, zoom, &canvas);
       }
     }
+    if (!dense.isEmpty())
+      drawEntityDensity(dense, canvas);
   }
 
   const OverlayItem::Cuboid viewingCuboid(OverlayItem::Point(x1 - 1, -4096, z1 - 1),
@@ -445,7 +597,9 @@ void MapView::redraw() {
 
   // draw the generated structures
   for (auto &type : overlayItemTypes) {
-    drawOverlayItems(overlayItems[type], viewingCuboid, x1, z1, canvas);
+    auto it = overlayItems.constFind(type);
+    if (it != overlayItems.constEnd())
+      drawOverlayItems(*it, viewingCuboid, x1, z1, canvas);
   }
 
   drawOverlayItems(currentSearchResults, viewingCuboid, x1, z1, canvas);
@@ -453,22 +607,58 @@ void MapView::redraw() {
   emit coordinatesChanged(x, depth, z);
 
   update();
+
+#if defined(DEBUG) || defined(_DEBUG) || defined(QT_DEBUG)
+  frameCount++;
+  frameTime = frameTimer.nsecsElapsed() / 1000;
+  frameTimeMax = std::max(frameTimeMax, frameTime);
+#endif
 }
 
 
-template<typename ListT>
-void MapView::drawOverlayItems(const ListT &list, const OverlayItem::Cuboid& cuboid, double x1, double z1, QPainter& canvas)
-{
-  for (auto &item : list) {
-    if (item->intersects(cuboid)) {
-      item->draw(x1, z1, zoom, &canvas);
-    }
+// Density raster for crowded areas: entities are counted per cell of
+// ENTITY_CELL x ENTITY_CELL pixels and all cells are drawn as one image
+void MapView::drawEntityDensity(const QVector<QPointF> &positions, QPainter &canvas) {
+  const int w = (imageOverlays.width()  + ENTITY_CELL - 1) / ENTITY_CELL;
+  const int h = (imageOverlays.height() + ENTITY_CELL - 1) / ENTITY_CELL;
+  QVector<int> counts(w * h, 0);
+  int maxCount = 1;
+  for (const QPointF &p : positions) {
+    int px = floor(p.x() / ENTITY_CELL);
+    int pz = floor(p.y() / ENTITY_CELL);
+    if ((px < 0) || (px >= w) || (pz < 0) || (pz >= h))
+      continue;
+    maxCount = std::max(maxCount, ++counts[px + pz * w]);
   }
+
+  // heat color: few entities yellow and translucent, most entities red and opaque
+  QImage raster(w, h, QImage::Format_ARGB32);
+  raster.fill(Qt::transparent);
+  const double logMax = log(1.0 + maxCount);
+  for (int i = 0; i < w * h; i++) {
+    if (counts[i] == 0) continue;
+    double heat = log(1.0 + counts[i]) / logMax;
+    raster.setPixel(i % w, i / w, QColor::fromHsvF((1.0 - heat) / 6, 1.0, 1.0, 0.5 + 0.5 * heat).rgba());
+  }
+  canvas.drawImage(QRect(0, 0, w * ENTITY_CELL, h * ENTITY_CELL), raster);
+}
+
+void MapView::drawOverlayItems(const OverlayIndex &index, const OverlayItem::Cuboid& cuboid, double x1, double z1, QPainter& canvas)
+{
+  index.forEach(cuboid, [&](const QSharedPointer<OverlayItem> &item) {
+    item->draw(x1, z1, zoom, &canvas);
+  });
 }
 
 void MapView::drawChunk(int x, int z) {
   if (!this->isEnabled())
     return;
+  // zoomed out views are drawn from TilePyramid
+  if (getLodLevel() > 0)
+    return;
+  // imageChunks still has the old scale, the scheduled redraw draws it
+  if (!drawnValid || (drawnZoom != zoom))
+    return;
 
   // fetch the chunk
   QSharedPointer<Chunk> chunk(cache.fetch(x, z));
@@ -476,58 +666,124 @@ void MapView::drawChunk(int x, int z) {
 
   if (chunk && chunk->rendering) return;
 
+  const int baseFlags = flags & ~ChunkRenderer::overlayFlags;
+  bool restored = false;
   if (chunk && (chunk->renderedAt != depth ||
-                chunk->renderedFlags != flags)) {
-    //renderChunk(chunk);
-    chunk->rendering = true;
-    ChunkRenderer *renderer = new ChunkRenderer(x, z, depth, flags);
-    connect(renderer, &ChunkRenderer::rendered,
-            [chunk](int, int) { chunk->rendering = false; });
-    connect(renderer, SIGNAL(rendered(int, int)),
-            this,     SLOT(chunkUpdated(int, int)));
-    QThreadPool::globalInstance()->start(renderer);
+                (chunk->renderedFlags & ~ChunkRenderer::overlayFlags) != baseFlags) &&
+      !(restored = chunk->restoreRenderVariant(depth, flags))) {
+    chunk->rendering = true;  // reset by ChunkRenderer
+    queueRender(x, z);
     return;
   }
+  if (chunk && (restored || (chunk->renderedFlags != flags))) {
+    // only overlay flags changed -> cheap update without Block scan
+    ChunkRenderer(x, z, depth, flags).renderOverlays(chunk);
+  }
 
   // this figures out where on the screen this chunk should be drawn
+  // (relative to the state of imageChunks, a redraw may be scheduled)
+  const int chunksize = qRound(16 * drawnZoom);
+  const int centerx = x * chunksize - drawnOrigin.x();
+  const int centery = z * chunksize - drawnOrigin.y();
 
-  // first find the center chunk
-  int centerchunkx = floor(this->x / 16);
-  int centerchunkz = floor(this->z / 16);
-  // and the center chunk screen coordinates
-  double centerx = imageChunks.width() / 2;
-  double centery = imageChunks.height() / 2;
-  // which need to be shifted to account for panning inside that chunk
-  centerx -= (this->x - centerchunkx * 16) * zoom;
-  centery -= (this->z - centerchunkz * 16) * zoom;
-  // centerx,y now points to the top left corner of the center chunk
-  // so now calculate our x,y in relation
-  double chunksize = 16 * zoom;
-  centerx += (x - centerchunkx) * chunksize;
-  centery += (z - centerchunkz) * chunksize;
-
-  const uchar* srcImageData = chunk ? chunk->getImage() : placeholder;
-  QImage srcImage(srcImageData, 16, 16, QImage::Format_RGB32);
-
-  QRectF targetRect(centerx, centery, chunksize, chunksize);
-
-  QPainter canvas(&imageChunks);
-  if (this->zoom < 1.0)
-      canvas.setRenderHint(QPainter::SmoothPixmapTransform);
-  canvas.drawImage(targetRect, srcImage);
+  const quint32 *srcImageData = reinterpret_cast<const quint32 *>(chunk ? chunk->getImage() : placeholder);
+  if (drawnZoom < 1.0)
+    Blitter::blitHalved(imageChunks, srcImageData, 16, centerx, centery);
+  else
+    Blitter::blitScaled(imageChunks, srcImageData, 16, centerx, centery, chunksize / 16);
 
   // Draw the ChunkLock overlay:
   if (this->flags & flgChunkLock) {
     if (chunk && chunk->getIsChunkLocked()) {
+      QPainter canvas(&imageChunks);
       canvas.setPen(QColor::fromRgb(0xff0000));
       canvas.setBrush(Qt::transparent);
-      double xAdj = (centerx > 0) ? 1 : 2;  // Adjustments are needed for chunks crossing the X or Y axis in viewspace
-      double yAdj = (centery > 0) ? 1 : 2;  // Otherwise their bottom / right edges are missing, most likely due to rounding.
-      canvas.drawRect(centerx, centery, chunksize - xAdj, chunksize - yAdj);
+      canvas.drawRect(centerx, centery, chunksize - 1, chunksize - 1);
     }
   }
 }
 
+void MapView::queueRender(int x, int z) {
+  const int size = ChunkRenderer::BATCH_SIZE;
+  ChunkID tile(floor(x / double(size)), floor(z / double(size)));
+  renderBatches[tile].append(ChunkID(x, z));
+
+  // collect all Chunks requested during this event loop iteration
+  // (redraw or a burst of loaded Chunks) before starting the batches
+  if (!renderBatchesScheduled) {
+    renderBatchesScheduled = true;
+    QTimer::singleShot(0, this, &MapView::startRenderBatches);
+  }
+}
+
+void MapView::startRenderBatches() {
+  renderBatchesScheduled = false;
+  for (const QList<ChunkID> &batch : renderBatches) {
+    ChunkRenderer *renderer = new ChunkRenderer(batch, depth, flags);
+    connect(renderer, SIGNAL(rendered(QList<ChunkID>)),
+            this,     SLOT(chunksRendered(QList<ChunkID>)));
+    QThreadPool::globalInstance()->start(renderer);
+  }
+  renderBatches.clear();
+}
+
+// screen position of the world origin in pixels (Blocks * zoom),
+// all Chunks and Tiles are drawn at integer offsets from it
+QPoint MapView::getPixelOrigin() const {
+  return QPoint(floor(x * zoom) - imageChunks.width()  / 2,
+                floor(z * zoom) - imageChunks.height() / 2);
+}
+
+// level of TilePyramid used for the current zoom, 0 when drawing Chunks
+int MapView::getLodLevel() const {
+  if (zoom > 1.0 / (1 << TilePyramid::LOD_MIN))
+    return 0;
+  return qRound(-log2(zoom));
+}
+
+void MapView::drawTile(int rx, int rz, int level, QPainter &canvas) {
+  // imageChunks still has the old scale, the scheduled redraw draws it
+  if (!drawnValid || (drawnZoom != zoom))
+    return;
+
+  // Tiles have one pixel per 2^level Blocks and match the zoom exactly
+  QPoint topLeft = QPoint(rx, rz) * (512 >> level) - drawnOrigin;
+  QRect target(topLeft, QSize(512 >> level, 512 >> level));
+
+  TilePyramid &pyramid = TilePyramid::Instance();
+  if (!pyramid.hasRegion(rx, rz))
+    return;
+
+  QImage tile = pyramid.getTile(level, rx, rz);
+  if (tile.isNull()) {
+    // not yet built -> show Chunk age from Region header instead
+    QImage overview = RegionOverview::Instance().getRegion(rx, rz);
+    if (overview.isNull())
+      canvas.fillRect(target, QColor(0x44, 0x44, 0x44));
+    else
+      canvas.drawImage(target, overview);
+  } else {
+    canvas.drawImage(topLeft, tile);
+  }
+}
+
+void MapView::tileReady(int rx, int rz) {
+  const int lod = getLodLevel();
+  if (lod == 0) return;
+
+  QPainter canvas(&imageChunks);
+  drawTile(rx, rz, lod, canvas);
+  canvas.end();
+  update();
+}
+
+void MapView::overviewScanned() {
+  if (getLodLevel() > 0) {
+    drawnValid = false;
+    redraw();
+  }
+}
+
 void MapView::getToolTip(int x, int z) {
   int cx = floor(x / 16.0);
   int cz = floor(z / 16.0);
@@ -541,15 +797,26 @@ void MapView::getToolTip(int x, int z) {
   QMap<QString, int> entityIds;
 
   if ((chunk) && (chunk->highest >= chunk->lowest)) {
-    int top = std::min(depth, chunk->highest);
+    int top = std::min(depth, chunk->getColumnTop(offset));
     for (y = top; y >= chunk->lowest; y--) {
       const ChunkSection *section = chunk->getSectionByY(y);
       if (!section) {
         // skip entire section
         int section_idx = (y >> 4);
-        y = (section_idx << 4) - 1;
+        y = (section_idx << 4);  // for loop will do an additional decrement
+        continue;
+      }
+      // jump to the next visible block in this section
+      quint16 candidates = section->getColumnMask(ChunkSection::mskVisible, offset);
+      if (flags & MapView::flgSeaGround)
+        candidates &= ~section->getColumnMask(ChunkSection::mskLiquid, offset);
+      candidates &= quint16((2 << (y & 0x0f)) - 1);
+      if (candidates == 0) {
+        y = (y & ~0x0f);  // skip rest of section
         continue;
       }
+      y = (y & ~0x0f) + 15 - qCountLeadingZeroBits(candidates);
+      if (y < chunk->lowest) break;
       // get information about block
       const PaletteEntry & pdata = section->getPaletteEntry(offset, y);
       blockname = pdata.name;
@@ -623,8 +890,12 @@ void MapView::getToolTip(int x, int z) {
 #if defined(DEBUG) || defined(_DEBUG) || defined(QT_DEBUG)
   hovertext += " [Cache:"
             + QString().number(this->cache.getCacheUsage()) + "/"
-            + QString().number(this->cache.getCacheMax()) + "]";
+            + QString().number(this->cache.getCacheMax()) + " Variants:"
+            + QString().number(this->cache.getRenderMemoryUsage() / 1024) + "kB]";
   hovertext += " Zoom:" + QString().number(zoomLevel);
+  hovertext += " Frame:" + QString().number(frameTime) + "us"
+            + " (max:" + QString().number(frameTimeMax) + "us #"
+            + QString().number(frameCount) + ")";
 #endif
 
   if (chunk && chunk->getIsChunkLocked()) {
@@ -634,15 +905,8 @@ void MapView::getToolTip(int x, int z) {
 }
 
 void MapView::addOverlayItem(QSharedPointer<OverlayItem> item) {
-  // test if item is already in list
-  for (auto &it: overlayItems[item->type()]) {
-    OverlayItem::Point p1 = it  ->midpoint();
-    OverlayItem::Point p2 = item->midpoint();
-    if ( (p1.x == p2.x) && (p1.y == p2.y) && (p1.z == p2.z) )
-      return;  // skip if already present
-  }
-  // otherwise add item
-  overlayItems[item->type()].push_back(item);
+  // skipped when already present
+  overlayItems[item->type()].insert(item);
 }
 
 void MapView::clearOverlayItems() {
@@ -651,6 +915,15 @@ void MapView::clearOverlayItems() {
 
 void MapView::setVisibleOverlayItemTypes(const QSet<QString>& itemTypes) {
   overlayItemTypes = itemTypes;
+  updateEntitiesNeeded();
+}
+
+void MapView::updateEntitiesNeeded() {
+  // ChunkLock state is stored in a marker Entity
+  bool needed = (flags & flgChunkLock);
+  for (auto &type : overlayItemTypes)
+    needed |= type.startsWith("Entity.");
+  cache.setEntitiesNeeded(needed);
 }
 
 int MapView::getY(int x, int z) {
@@ -670,13 +943,13 @@ QList<QSharedPointer<OverlayItem>> MapView::getItems(int x, int y, int z) {
     double invzoom = 10.0 / zoom;
     for (auto &type : overlayItemTypes) {
       // generated structures
-      for (auto &item : overlayItems[type]) {
+      auto it = overlayItems.constFind(type);
+      if (it != overlayItems.constEnd()) {
         double ymin = chunk->lowest;
         double ymax = depth;
-        if (item->intersects(OverlayItem::Point(x, ymin, z),
-                             OverlayItem::Point(x, ymax, z))) {
-          ret.append(item);
-        }
+        it->forEach(OverlayItem::Cuboid(OverlayItem::Point(x, ymin, z),
+                                        OverlayItem::Point(x, ymax, z)),
+                    [&ret](const QSharedPointer<OverlayItem> &item) { ret.append(item); });
       }
 
       // entities
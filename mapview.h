@@ -4,7 +4,9 @@
 
 #include <QtWidgets/QWidget>
 #include <QSharedPointer>
+#include <QTimer>
 #include "chunkcache.h"
+#include "overlay/overlayindex.h"
 
 class DefinitionManager;
 class BiomeIdentifier;
@@ -64,7 +66,12 @@ class MapView : public QWidget {
  public slots:
   void setDepth(int depth);
   void chunkUpdated(int x, int z);
+  void entitiesUpdated(int x, int z);
+  void chunksRendered(const QList<ChunkID> &chunks);
+  void tileReady(int rx, int rz);
+  void overviewScanned();
   void redraw();
+  void scheduleRedraw();  // redraw with next display frame
 
   // Clears the cache and redraws, causing all chunks to be re-loaded;
   // but keeps the viewport
@@ -89,17 +96,27 @@ class MapView : public QWidget {
 
  private:
   void drawChunk(int x, int z);
+  void queueRender(int x, int z);
+  void startRenderBatches();
+  QPoint getPixelOrigin() const;
+  int  getLodLevel() const;
+  void drawTile(int rx, int rz, int level, QPainter &canvas);
   void getToolTip(int x, int z);
   int getY(int x, int z);
   QList<QSharedPointer<OverlayItem>> getItems(int x, int y, int z);
   void adjustZoom(double steps, bool allowZoomOut, bool cursorSource);
 
-  template<typename ListT>
-  void drawOverlayItems(const ListT& list, const OverlayItem::Cuboid& cuboid, double x1, double z1, QPainter& canvas);
+  void updateEntitiesNeeded();  // Entities are loaded only when some are shown
+  void drawEntityDensity(const QVector<QPointF> &positions, QPainter &canvas);
+  void drawOverlayItems(const OverlayIndex &index, const OverlayItem::Cuboid& cuboid, double x1, double z1, QPainter& canvas);
 
   static const int CAVE_DEPTH = 16;  // maximum depth caves are searched in cave mode
   float caveshade[CAVE_DEPTH];
 
+  static const int ENTITY_GLYPH_AREA  = 32;  // pixel size of screen areas entities are counted in
+  static const int ENTITY_GLYPH_LIMIT = 8;   // more entities in one area are drawn as density raster
+  static const int ENTITY_CELL = 4;          // pixel size of density raster cells
+
   int depth;
   double x, z;
   int scale;
@@ -113,10 +130,29 @@ class MapView : public QWidget {
   DefinitionManager *dm;
   uchar placeholder[16 * 16 * 4];  // no chunk found placeholder
   QSet<QString> overlayItemTypes;
-  QMap<QString, QList<QSharedPointer<OverlayItem>>> overlayItems;
+  QMap<QString, OverlayIndex> overlayItems;
   BlockLocation currentLocation;
 
-  QVector<QSharedPointer<OverlayItem> > currentSearchResults;
+  OverlayIndex currentSearchResults;
+
+  QTimer redrawTimer;
+
+  // frame statistics (debug builds only)
+  int    frameCount   = 0;
+  qint64 frameTime    = 0;  // us
+  qint64 frameTimeMax = 0;  // us
+
+  // state of the last redraw, to reuse imageChunks while scrolling
+  bool   drawnValid = false;
+  QPoint drawnOrigin;
+  QSize  drawnSize;
+  double drawnZoom  = 0;
+  int    drawnDepth = 0;
+  int    drawnFlags = 0;
+
+  // Chunks waiting for rendering, grouped into tiles of ChunkRenderer::BATCH_SIZE^2
+  QHash<ChunkID, QList<ChunkID>> renderBatches;
+  bool renderBatchesScheduled = false;
 };
 
 #endif  // MAPVIEW_H_
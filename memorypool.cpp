@@ -0,0 +1,63 @@
+/** Copyright (c) 2026, EtlamGit */
+
+#include <algorithm>
+
+#include "memorypool.h"
+
+
+// all blocks are aligned for any fundamental type
+static const size_t poolAlignment = alignof(std::max_align_t);
+
+static size_t alignBlockSize(size_t size) {
+  size = std::max<size_t>(size, sizeof(void *));
+  return (size + poolAlignment - 1) & ~(poolAlignment - 1);
+}
+
+MemoryPool::MemoryPool(size_t blockSize, size_t slabSize)
+  : blockSize(alignBlockSize(blockSize))
+  , blocksPerSlab(std::max<size_t>(1, slabSize / alignBlockSize(blockSize)))
+{}
+
+MemoryPool::~MemoryPool() {
+  for (auto slab : slabs)
+    ::operator delete(slab);
+  slabs.clear();
+  freeBlocks.clear();
+}
+
+void * MemoryPool::allocate() {
+  QMutexLocker guard(&mutex);
+  if (freeBlocks.empty())
+    allocateSlab();
+  void * block = freeBlocks.back();
+  freeBlocks.pop_back();
+  return block;
+}
+
+void MemoryPool::release(void * block) {
+  if (block == nullptr)
+    return;
+  QMutexLocker guard(&mutex);
+  freeBlocks.push_back(block);
+}
+
+size_t MemoryPool::getUsedBlocks() const {
+  QMutexLocker guard(&mutex);
+  return slabs.size() * blocksPerSlab - freeBlocks.size();
+}
+
+size_t MemoryPool::getFreeBlocks() const {
+  QMutexLocker guard(&mutex);
+  return freeBlocks.size();
+}
+
+// called with locked mutex
+void MemoryPool::allocateSlab() {
+  // ::operator new returns memory aligned to max_align_t
+  char * slab = static_cast<char *>(::operator new(blockSize * blocksPerSlab));
+  slabs.push_back(slab);
+  freeBlocks.reserve(freeBlocks.size() + blocksPerSlab);
+  // push in reverse order, so blocks are handed out in ascending addresses
+  for (size_t i = blocksPerSlab; i > 0; i--)
+    freeBlocks.push_back(slab + (i - 1) * blockSize);
+}
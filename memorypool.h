@@ -0,0 +1,115 @@
+/** Copyright (c) 2026, EtlamGit */
+#ifndef MEMORYPOOL_H_
+#define MEMORYPOOL_H_
+
+#include <QMutex>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+
+// Pool of fixed size memory blocks.
+// Blocks are carved out of bigger slabs and are recycled when released,
+// instead of being handed back to the heap. Chunks and Sections are created
+// and destroyed all the time while panning, this keeps malloc out of the
+// loop and avoids fragmentation of the heap.
+class MemoryPool {
+ public:
+  explicit MemoryPool(size_t blockSize, size_t slabSize = 64 * 1024);
+  ~MemoryPool();
+
+  void * allocate();
+  void   release(void * block);
+
+  size_t getBlockSize() const { return blockSize; }
+  size_t getUsedBlocks() const;  // blocks currently handed out
+  size_t getFreeBlocks() const;  // blocks waiting for reuse
+
+ private:
+  // prevent access to copyconstructor
+  MemoryPool(const MemoryPool &);
+  MemoryPool &operator=(const MemoryPool &);
+
+  void allocateSlab();
+
+  const size_t blockSize;
+  const size_t blocksPerSlab;
+  mutable QMutex      mutex;
+  std::vector<void *> freeBlocks;
+  std::vector<char *> slabs;
+};
+
+
+// Base class to allocate all instances of a class from one MemoryPool.
+// Derived classes with a different size fall back to the default heap.
+template <typename T>
+class PooledObject {
+ public:
+  static void * operator new(size_t size) {
+    if (size != sizeof(T))
+      return ::operator new(size);
+    return pool().allocate();
+  }
+
+  static void operator delete(void * p, size_t size) {
+    if (p == nullptr)
+      return;
+    if (size != sizeof(T))
+      ::operator delete(p);
+    else
+      pool().release(p);
+  }
+
+  static MemoryPool & pool() {
+    // never destroyed: pooled objects may be released after static destruction started
+    static MemoryPool * singleton = new MemoryPool(sizeof(T));
+    return *singleton;
+  }
+};
+
+
+// Pool for arrays of variable length, grouped into power of two size classes.
+// Arrays longer than MaxLength are allocated on the default heap.
+template <typename T, int MaxLength>
+class ArrayPool {
+ public:
+  static T * allocate(int length) {
+    if (length <= 0)
+      return nullptr;
+    if (length > MaxLength)
+      return new T[length];
+    T * array = static_cast<T *>(pool(length).allocate());
+    for (int i = 0; i < length; i++)
+      new (array + i) T();
+    return array;
+  }
+
+  static void release(T * array, int length) {
+    if ((array == nullptr) || (length <= 0))
+      return;
+    if (length > MaxLength) {
+      delete[] array;
+      return;
+    }
+    for (int i = 0; i < length; i++)
+      array[i].~T();
+    pool(length).release(array);
+  }
+
+ private:
+  static MemoryPool & pool(int length) {
+    // never destroyed: see PooledObject
+    static const std::vector<MemoryPool *> pools = [] {
+      std::vector<MemoryPool *> list;
+      for (int len = 1; len < 2 * MaxLength; len *= 2)
+        list.push_back(new MemoryPool(len * sizeof(T)));
+      return list;
+    }();
+    int sizeClass = 0;
+    while ((1 << sizeClass) < length)
+      sizeClass++;
+    return *pools[sizeClass];
+  }
+};
+
+#endif  // MEMORYPOOL_H_
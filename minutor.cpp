@@ -51,8 +51,8 @@ Minutor::Minutor()
           this,    SLOT(showProperties(QVariant)));
 
   ChunkCache const & cache = ChunkCache::Instance();
-  connect(&cache, &ChunkCache::structureFound,
-          this,   &Minutor::addStructureFromChunk);
+  connect(&cache, &ChunkCache::structuresFound,
+          this,   &Minutor::addStructuresFromChunk);
 
   // Definition manager
   dm = new DefinitionManager(this);
@@ -1106,19 +1106,21 @@ void Minutor::addOverlayItemType(QString path, QString type,
   }
 }
 
-void Minutor::addStructureFromChunk(QSharedPointer<GeneratedStructure> structure) {
-  // update menu (if necessary)
-  QString type = structure->type();
-  QString path;
-  if (!type.contains("minecraft:")) {
-    // not vanilla -> structure from a mod
-    QStringList mod = type.split(QRegularExpression("[.:]"));
-    path = mod[1];
-  }
+void Minutor::addStructuresFromChunk(QList<QSharedPointer<GeneratedStructure>> structures) {
+  for (auto &structure : structures) {
+    // update menu (if necessary)
+    QString type = structure->type();
+    QString path;
+    if (!type.contains("minecraft:")) {
+      // not vanilla -> structure from a mod
+      QStringList mod = type.split(QRegularExpression("[.:]"));
+      path = mod[1];
+    }
 
-  addOverlayItemType(path, type, structure->color());
-  // add to list with overlays
-  mapview->addOverlayItem(structure);
+    addOverlayItemType(path, type, structure->color());
+    // add to list with overlays
+    mapview->addOverlayItem(structure);
+  }
 }
 
 void Minutor::addOverlayItem(QSharedPointer<OverlayItem> item) {
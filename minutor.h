@@ -89,7 +89,7 @@ private slots:
   void rescanWorlds();
   void saveProgress(QString status, double value);
   void saveFinished();
-  void addStructureFromChunk(QSharedPointer<GeneratedStructure> structure);
+  void addStructuresFromChunk(QList<QSharedPointer<GeneratedStructure>> structures);
   void addOverlayItem(QSharedPointer<OverlayItem> item);
   QMenu* addOverlayItemMenu(QString path);
   void addOverlayItemType(QString path, QString type, QColor color, QString dimension = "");
@@ -20,12 +20,15 @@ HEADERS += \
     labelledseparator.h \
     labelledslider.h \
     clamp.h \
+    blitter.h \
     chunk.h \
     chunkcache.h \
     chunkloader.h \
     chunkrenderer.h \
+    columnblend.h \
     identifier/biomeidentifier.h \
     identifier/blockidentifier.h \
+    identifier/blockstateregistry.h \
     identifier/definitionmanager.h \
     identifier/definitionupdater.h \
     identifier/dimensionidentifier.h \
@@ -35,18 +38,22 @@ HEADERS += \
     lz4/lz4.h \
     lz4/xxhash.h \
     mapview.h \
+    memorypool.h \
     minutor.h \
     nbt/nbt.h \
     nbt/tag.h \
     nbt/tagdatastream.h \
     overlay/entity.h \
     overlay/generatedstructure.h \
+    overlay/overlayindex.h \
     overlay/overlayitem.h \
     overlay/properties.h \
     overlay/propertietreecreator.h \
     overlay/village.h \
     paletteentry.h \
     pngexport.h \
+    regionoverview.h \
+    rendervariant.h \
     search/entityevaluator.h \
     search/range.h \
     search/rectangleinnertoouteriterator.h \
@@ -62,6 +69,7 @@ HEADERS += \
     search/statisticlabel.h \
     search/statisticresultitem.h \
     settings.h \
+    tilepyramid.h \
     worldinfo.h \
     worldsave.h \
     zipreader.h
@@ -69,12 +77,14 @@ SOURCES += \
     java.cpp \
     labelledseparator.cpp \
     labelledslider.cpp \
+    blitter.cpp \
     chunk.cpp \
     chunkcache.cpp \
     chunkloader.cpp \
     chunkrenderer.cpp \
     identifier/biomeidentifier.cpp \
     identifier/blockidentifier.cpp \
+    identifier/blockstateregistry.cpp \
     identifier/definitionmanager.cpp \
     identifier/definitionupdater.cpp \
     identifier/dimensionidentifier.cpp \
@@ -85,16 +95,19 @@ SOURCES += \
     lz4/xxhash.c \
     main.cpp \
     mapview.cpp \
+    memorypool.cpp \
     minutor.cpp \
     nbt/nbt.cpp \
     nbt/tag.cpp \
     nbt/tagdatastream.cpp \
     overlay/entity.cpp \
     overlay/generatedstructure.cpp \
+    overlay/overlayindex.cpp \
     overlay/properties.cpp \
     overlay/propertietreecreator.cpp \
     overlay/village.cpp \
     pngexport.cpp \
+    regionoverview.cpp \
     search/entityevaluator.cpp \
     search/searchblockplugin.cpp \
     search/searchchunksdialog.cpp \
@@ -104,6 +117,7 @@ SOURCES += \
     search/searchtextwidget.cpp \
     search/statisticdialog.cpp \
     settings.cpp \
+    tilepyramid.cpp \
     worldinfo.cpp \
     worldsave.cpp \
     zipreader.cpp
@@ -58,17 +58,17 @@ void NBT::unpack_zlib(const unsigned char * data, unsigned long length, int wind
   stream.next_in  = const_cast<unsigned char *>(data);  // yes we violate "const", but zlib will not change the input data
 
   // intermediate buffer for decompression
-  char buffer[CHUNK_SIZE];
+  char inflated[CHUNK_SIZE];
 
   // final buffer for decompressed NBT data
-  QByteArray nbt;
+  QByteArray &nbt = buffer;
 
   inflateInit2(&stream, windowsize);
   do {
     stream.avail_out = CHUNK_SIZE;
-    stream.next_out = reinterpret_cast<Bytef *>(buffer);
+    stream.next_out = reinterpret_cast<Bytef *>(inflated);
     inflate(&stream, Z_NO_FLUSH);
-    nbt.append(buffer, CHUNK_SIZE - stream.avail_out);
+    nbt.append(inflated, CHUNK_SIZE - stream.avail_out);
   } while (stream.avail_out == 0);
   inflateEnd(&stream);
 
@@ -96,7 +96,7 @@ long readIntLE(const unsigned char * data) {
 void NBT::unpack_lz4(const unsigned char * data, unsigned long length) {
   if (length < LZ4_MAGIC_LENGTH+13) return;
 
-  QByteArray nbt;
+  QByteArray &nbt = buffer;
 
   const unsigned char * input = data;
 
@@ -2,6 +2,7 @@
 #ifndef NBT_H_
 #define NBT_H_
 
+#include <QByteArray>
 #include <QString>
 
 #include "nbt/tag.h"
@@ -24,7 +25,8 @@ class NBT {
   void decode_nbt(const unsigned char * data, unsigned long length);
   void decode_nbt(const char * data, unsigned long length);
 
-  Tag * root;
+  Tag *      root;
+  QByteArray buffer;  // decompressed data, raw Tag data refers to it
 };
 
 #endif  // NBT_H_
@@ -22,6 +22,10 @@ bool Tag::has(const QString) const {
   return false;
 }
 
+const QStringList Tag::keys() const {
+  return QStringList();
+}
+
 const Tag *Tag::at(const QString) const {
   return &NBT::Null;
 }
@@ -68,6 +72,11 @@ const QVariant Tag::getData() const {
   return QVariant();
 }
 
+const QByteArray Tag::getRawData() const {
+  qWarning() << "tag::getRawData unhandled in base class";
+  return QByteArray();
+}
+
 
 // Tag_Byte
 
@@ -332,7 +341,10 @@ const QVariant Tag_List::getData() const {
 
 // Tag_Compound
 
-Tag_Compound::Tag_Compound(TagDataStream *s) {
+Tag_Compound::Tag_Compound(TagDataStream *s)
+  : rawBegin(s->current())
+  , rawLength(0)
+{
   quint8 type;
   while ((type = s->r8()) != TAG_END) { // parse until we reach TAG_END
     quint16 len = s->r16();
@@ -355,6 +367,8 @@ Tag_Compound::Tag_Compound(TagDataStream *s) {
     }
     children.insert(key, child);
   }
+  // including the terminating TAG_END, so the data can be parsed again
+  rawLength = s->current() - rawBegin;
 }
 
 Tag_Compound::~Tag_Compound() {
@@ -366,6 +380,10 @@ bool Tag_Compound::has(const QString key) const {
   return children.contains(key);
 }
 
+const QStringList Tag_Compound::keys() const {
+  return children.keys();
+}
+
 const Tag *Tag_Compound::at(const QString key) const {
   auto iter = children.find(key);
   if (iter == children.end())
@@ -395,6 +413,11 @@ const QVariant Tag_Compound::getData() const {
   return map;
 }
 
+const QByteArray Tag_Compound::getRawData() const {
+  // deep copy, as the NBT data is released after parsing
+  return QByteArray(rawBegin, rawLength);
+}
+
 
 // Tag_Int_Array
 
@@ -2,7 +2,9 @@
 #define TAG_H
 
 #include <vector>
+#include <QByteArray>
 #include <QString>
+#include <QStringList>
 #include <QVariant>
 
 #include "nbt/tagdatastream.h"
@@ -14,6 +16,7 @@ class Tag {
   virtual ~Tag();
 
   virtual bool                        has(const QString key) const;
+  virtual const QStringList           keys() const;
   virtual int                         length() const;
   virtual const Tag *                 at(const QString key) const;
   virtual const Tag *                 at(int index) const;
@@ -24,6 +27,7 @@ class Tag {
   virtual const std::vector<qint32> & toIntArray() const;
   virtual const std::vector<qint64> & toLongArray() const;
   virtual const QVariant              getData() const;
+  virtual const QByteArray            getRawData() const;  // only while NBT data is alive
 
   enum TagType {
     TAG_END        = 0,
@@ -161,13 +165,17 @@ class Tag_Compound : public Tag {
   explicit Tag_Compound(TagDataStream *s);
   ~Tag_Compound();
 
-  bool           has(const QString key) const override;
-  const Tag *    at(const QString key) const override;
-  int            length() const override;
-  const QString  toString() const override;
-  const QVariant getData() const override;
+  bool              has(const QString key) const override;
+  const QStringList keys() const override;
+  const Tag *       at(const QString key) const override;
+  int               length() const override;
+  const QString     toString() const override;
+  const QVariant    getData() const override;
+  const QByteArray  getRawData() const override;  // serialized children (with TAG_END)
  private:
   QHash<QString, Tag *> children;
+  const char *          rawBegin;   // location in NBT data, to extract raw data
+  int                   rawLength;
 };
 
 class Tag_Int_Array : public Tag {
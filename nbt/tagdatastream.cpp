@@ -54,3 +54,7 @@ QString TagDataStream::utf8(int len) {
 void TagDataStream::skip(int len) {
   pos += len;
 }
+
+const char * TagDataStream::current() const {
+  return reinterpret_cast<const char *>(data + pos);
+}
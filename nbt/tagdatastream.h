@@ -15,6 +15,7 @@ class TagDataStream {
   void    r(int len, std::vector<quint8> &data_out);  // read <len> bytes
   QString utf8(int len);                              // read UTF8 encoded string
   void    skip(int len);                              // skip <len> bytes of data
+  const char * current() const;                       // pointer to current read position
  private:
   const quint8 *data;
   int pos, len;
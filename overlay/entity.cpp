@@ -23,8 +23,6 @@ QSharedPointer<OverlayItem> Entity::TryParse(const Tag* tag) {
       QString type = id->toString().toLower().remove("minecraft:");
       EntityInfo const & info = ei.getEntityInfo(type);
 
-      QMap<QString, QVariant> props = tag->getData().toMap();
-
       // get something more descriptive if its an item
       if (type == "item") {
         auto itemId = tag->at("Item")->at("id");
@@ -40,13 +38,14 @@ QSharedPointer<OverlayItem> Entity::TryParse(const Tag* tag) {
       entity->setType("Entity." + info.category);
       entity->setColor(info.brushColor);
       entity->setExtraColor(info.penColor);
-      entity->setProperties(props);
+      // keep only the raw NBT data, properties are created when needed
+      entity->rawNbt = tag->getRawData();
 
       // parse POI of villagers / PiglinBrutes
-      if (props.contains("Brain")) {
-        QMap<QString, QVariant> brain = props["Brain"].toMap();
-        if (brain.contains("memories")) {
-          QMap<QString, QVariant> memories = brain["memories"].toMap();
+      if (tag->has("Brain")) {
+        const Tag *brain = tag->at("Brain");
+        if (brain->has("memories")) {
+          const Tag *memories = brain->at("memories");
           // home is location of bed
           entity->tryParseMemory(memories, "minecraft:home",               QColor(0,0,255));
 
@@ -65,24 +64,33 @@ QSharedPointer<OverlayItem> Entity::TryParse(const Tag* tag) {
   return ret;
 }
 
-void Entity::tryParseMemory(const QMap<QString, QVariant> &memories,
+void Entity::tryParseMemory(const Tag *memories,
                             const QString memory,
                             QColor color) {
-  if (memories.contains(memory)) {
-    QMap<QString, QVariant> location = memories[memory].toMap();
-    QList<QVariant> pos;
-    if (location.contains("value")) {
-      QMap<QString, QVariant> value = location["value"].toMap();
-      pos = value["pos"].toList();
-    } else if (location.contains("pos")) {
-      pos = location["pos"].toList();
+  if (memories->has(memory)) {
+    const Tag *location = memories->at(memory);
+    const Tag *pos;
+    if (location->has("value") && location->at("value")->has("pos")) {
+      pos = location->at("value")->at("pos");
+    } else if (location->has("pos")) {
+      pos = location->at("pos");
     } else return;
-    POI p(pos[0].toInt(), pos[2].toInt());
+    const std::vector<qint32> &xyz = pos->toIntArray();
+    if (xyz.size() < 3) return;
+    POI p(xyz[0], xyz[2]);
     p.color = color;
     this->poiList.append(p);
   }
 }
 
+QVariant Entity::properties() const {
+  if (rawNbt.isEmpty())
+    return OverlayItem::properties();
+  TagDataStream s(rawNbt.constData(), rawNbt.size());
+  Tag_Compound tag(&s);
+  return tag.getData();
+}
+
 
 bool Entity::intersects(const OverlayItem::Cuboid& cuboid) const {
   return cuboid.min.x <= pos.x && cuboid.max.x >= pos.x &&
@@ -17,6 +17,7 @@ class Entity: public OverlayItem {
   virtual void draw(double offsetX, double offsetZ, double scale,
                     QPainter *canvas) const;
   virtual Point midpoint() const;
+  virtual QVariant properties() const;  // built on demand from raw NBT data
   void setExtraColor(const QColor& c) {extraColor = c;}
 
   static const int RADIUS = 5;
@@ -28,6 +29,7 @@ class Entity: public OverlayItem {
   QColor extraColor;
   Point pos;
   QString display;
+  QByteArray rawNbt;  // serialized NBT Compound of this Entity
 
   // optional POI location(s)
   struct POI {
@@ -38,7 +40,7 @@ class Entity: public OverlayItem {
   };
   QList<POI> poiList;
 
-  void tryParseMemory(const QMap<QString, QVariant> &memories, const QString memory, QColor color);
+  void tryParseMemory(const Tag *memories, const QString memory, QColor color);
 };
 
 #endif  // ENTITY_H_
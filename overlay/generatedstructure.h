@@ -19,6 +19,7 @@ class GeneratedStructure: public OverlayItem {
   virtual void draw(double offsetX, double offsetZ, double scale,
                    QPainter *canvas) const;
   virtual Point midpoint() const;
+  virtual Cuboid bounds() const { return Cuboid(p1, p2); }
 
  protected:
   GeneratedStructure() {}
@@ -0,0 +1,34 @@
+/** Copyright (c) 2026, EtlamGit */
+
+#include <algorithm>
+
+#include "overlay/overlayindex.h"
+
+uint qHash(const OverlayIndex::Position &p, uint seed) {
+  return qHash(p.type, seed) ^ qHash(p.x, seed) ^ qHash(p.y * 31, seed) ^ qHash(p.z * 1021, seed);
+}
+
+bool OverlayIndex::insert(const QSharedPointer<OverlayItem> &item) {
+  OverlayItem::Point mid = item->midpoint();
+  Position p{item->type(), mid.x, mid.y, mid.z};
+  if (positions.contains(p))
+    return false;  // skip if already present
+  positions.insert(p);
+  append(item);
+  return true;
+}
+
+void OverlayIndex::append(const QSharedPointer<OverlayItem> &item) {
+  OverlayItem::Cuboid box = item->bounds();
+  const int cx = cell(box.min.x), cz = cell(box.min.z);
+  maxSpan = std::max(maxSpan, std::max(cell(box.max.x) - cx, cell(box.max.z) - cz));
+  cells[key(cx, cz)].append(item);
+  count++;
+}
+
+void OverlayIndex::clear() {
+  cells.clear();
+  positions.clear();
+  maxSpan = 0;
+  count = 0;
+}
@@ -0,0 +1,66 @@
+/** Copyright (c) 2026, EtlamGit */
+#ifndef OVERLAYINDEX_H_
+#define OVERLAYINDEX_H_
+
+#include <cmath>
+#include <QHash>
+#include <QSet>
+#include <QSharedPointer>
+#include <QVector>
+#include "overlay/overlayitem.h"
+
+// Grid based spatial index for OverlayItems.
+// Items are stored in the grid cell of their minimum corner, queries look
+// into as many cells to the negative side as the biggest item spans.
+class OverlayIndex {
+ public:
+  OverlayIndex() : maxSpan(0), count(0) {}
+
+  // add item, returns false when an item of same type was already at that position
+  bool insert(const QSharedPointer<OverlayItem> &item);
+  // add item without duplicate detection
+  void append(const QSharedPointer<OverlayItem> &item);
+  void clear();
+  int  size() const { return count; }
+
+  // call f(item) for all items intersecting cuboid
+  template<typename F>
+  void forEach(const OverlayItem::Cuboid &cuboid, F f) const;
+
+ private:
+  static const int CELL_SHIFT = 9;  // 512 Blocks, one Region
+
+  static int cell(double v) { return static_cast<int>(floor(v)) >> CELL_SHIFT; }
+  static qint64 key(int cx, int cz) { return (qint64(cx) << 32) | quint32(cz); }
+
+  struct Position {
+    QString type;
+    double x, y, z;
+    bool operator==(const Position &other) const {
+      return (x == other.x) && (y == other.y) && (z == other.z) && (type == other.type);
+    }
+  };
+  friend uint qHash(const Position &p, uint seed);
+
+  QHash<qint64, QVector<QSharedPointer<OverlayItem>>> cells;
+  QSet<Position> positions;  // for duplicate detection
+  int maxSpan;               // biggest item size in cells
+  int count;
+};
+
+template<typename F>
+void OverlayIndex::forEach(const OverlayItem::Cuboid &cuboid, F f) const {
+  if (count == 0) return;
+  const int cx1 = cell(cuboid.min.x) - maxSpan, cx2 = cell(cuboid.max.x);
+  const int cz1 = cell(cuboid.min.z) - maxSpan, cz2 = cell(cuboid.max.z);
+  for (int cz = cz1; cz <= cz2; cz++)
+    for (int cx = cx1; cx <= cx2; cx++) {
+      auto it = cells.constFind(key(cx, cz));
+      if (it == cells.constEnd()) continue;
+      for (const QSharedPointer<OverlayItem> &item : *it)
+        if (item->intersects(cuboid))
+          f(item);
+    }
+}
+
+#endif  // OVERLAYINDEX_H_
@@ -31,9 +31,14 @@ class OverlayItem {
   virtual void draw(double offsetX, double offsetZ, double scale,
                     QPainter *canvas) const = 0;
   virtual Point midpoint() const = 0;
+  // bounding box used for spatial indexing
+  virtual Cuboid bounds() const {
+    Point mid = midpoint();
+    return Cuboid(mid, mid);
+  }
   const QString& type() const {return itemType;}
   const QString& display() const { return itemDescription;}
-  const QVariant& properties() const { return itemProperties;}
+  virtual QVariant properties() const { return itemProperties;}
   const QColor& color() const { return itemColor; }
   const QString& dimension() const { return itemDimension; }
 
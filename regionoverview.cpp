@@ -0,0 +1,143 @@
+/** Copyright (c) 2026, EtlamGit */
+
+#include <algorithm>
+#include <cmath>
+
+#include <QColor>
+#include <QDirIterator>
+#include <QFile>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QtEndian>
+#include <QVector>
+
+#include "regionoverview.h"
+
+
+// reads location and timestamp table of all Region files in one pass
+class RegionScanner : public QRunnable {
+ public:
+  RegionScanner(QString path, int generation) : path(path), generation(generation) {}
+
+ protected:
+  void run();
+
+ private:
+  QString path;
+  int generation;
+};
+
+void RegionScanner::run() {
+  struct Header {
+    ChunkID id;
+    QVector<quint32> timestamps;  // 0 for missing Chunks
+  };
+  QList<Header> headers;
+  quint32 newest = 0;
+
+  QDirIterator it(path + "/region", QStringList() << "r.*.*.mca", QDir::Files);
+  while (it.hasNext()) {
+    // stop early when another world was opened meanwhile
+    if (RegionOverview::Instance().isOutdated(generation))
+      return;
+    it.next();
+    // figure out the X & Z of the region
+    // -> split filename into parts, we expect 4 of them: "r" "X" "Z" "mca"
+    QStringList nameParts = it.fileName().split(".");
+    if (nameParts.length() != 4)
+      continue;
+
+    QFile f(it.filePath());
+    // skip region files without complete header
+    if (f.size() < 2 * 4096 || !f.open(QIODevice::ReadOnly))
+      continue;
+    QByteArray data = f.read(2 * 4096);
+    f.close();
+    if (data.size() < 2 * 4096)
+      continue;
+
+    // first 4KiB: location table, second 4KiB: timestamp table (both big endian)
+    const uchar *locations  = reinterpret_cast<const uchar *>(data.constData());
+    const uchar *timestamps = locations + 4096;
+    Header header{ChunkID(nameParts[1].toInt(), nameParts[2].toInt()), QVector<quint32>(32 * 32, 0)};
+    bool hasChunk = false;
+    for (int i = 0; i < 32 * 32; i++) {
+      if (qFromBigEndian<quint32>(locations + 4 * i) == 0)
+        continue;
+      // a present Chunk has at least timestamp 1, to distinguish it from a missing one
+      quint32 time = std::max<quint32>(1, qFromBigEndian<quint32>(timestamps + 4 * i));
+      header.timestamps[i] = time;
+      newest = std::max(newest, time);
+      hasChunk = true;
+    }
+    if (hasChunk)
+      headers.append(header);
+  }
+
+  // color by age relative to the newest Chunk, logarithmic from one hour to one year
+  const double hour = 3600.0;
+  const double year = 365.0 * 24 * hour;
+  QHash<ChunkID, QImage> images;
+  for (const Header &header : headers) {
+    QImage image(32, 32, QImage::Format_ARGB32_Premultiplied);
+    for (int i = 0; i < 32 * 32; i++) {
+      QRgb color = 0;
+      if (header.timestamps[i] > 0) {
+        double age = std::max(hour, double(newest - header.timestamps[i]));
+        double heat = std::min(1.0, std::log(age / hour) / std::log(year / hour));
+        color = QColor::fromHsv(static_cast<int>(240 * heat), 200, 220).rgb();
+      }
+      image.setPixel(i & 31, i >> 5, color);
+    }
+    images.insert(header.id, image);
+  }
+
+  RegionOverview::Instance().store(generation, images);
+}
+
+
+RegionOverview::RegionOverview()
+  : generation(0)
+{
+  scanPool.setMaxThreadCount(1);
+}
+
+RegionOverview::~RegionOverview() {
+  {
+    QMutexLocker guard(&mutex);
+    generation++;
+  }
+  scanPool.clear();
+  scanPool.waitForDone();
+}
+
+RegionOverview &RegionOverview::Instance() {
+  static RegionOverview singleton;
+  return singleton;
+}
+
+void RegionOverview::setPath(QString path) {
+  QMutexLocker guard(&mutex);
+  regions.clear();
+  scanPool.clear();
+  scanPool.start(new RegionScanner(path, ++generation));
+}
+
+QImage RegionOverview::getRegion(int rx, int rz) {
+  QMutexLocker guard(&mutex);
+  return regions.value(ChunkID(rx, rz));
+}
+
+bool RegionOverview::isOutdated(int generation) {
+  QMutexLocker guard(&mutex);
+  return this->generation != generation;
+}
+
+void RegionOverview::store(int generation, QHash<ChunkID, QImage> images) {
+  {
+    QMutexLocker guard(&mutex);
+    if (this->generation != generation) return;
+    regions = images;
+  }
+  emit scanned();
+}
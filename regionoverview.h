@@ -0,0 +1,50 @@
+/** Copyright (c) 2026, EtlamGit */
+#ifndef REGIONOVERVIEW_H_
+#define REGIONOVERVIEW_H_
+
+#include <QObject>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QThreadPool>
+#include "chunkid.h"
+
+// Instant overview of a whole world based on Region file headers only.
+// Each Region is shown as 32x32 pixels (one per Chunk): missing Chunks are
+// transparent, existing Chunks are colored by their last modification time
+// (red: recently modified, blue: not modified for a long time).
+// Used as placeholder until the TilePyramid has built the Tile of a Region.
+class RegionOverview : public QObject {
+  Q_OBJECT
+
+ public:
+  // singleton: access to global usable instance
+  static RegionOverview &Instance();
+ private:
+  // singleton: prevent access to constructor and copyconstructor
+  RegionOverview();
+  ~RegionOverview();
+  RegionOverview(const RegionOverview &);
+  RegionOverview &operator=(const RegionOverview &);
+
+ public:
+  void setPath(QString path);  // starts scanning Region headers in background
+
+  // null image when Region does not exist or is not yet scanned
+  QImage getRegion(int rx, int rz);
+
+ signals:
+  void scanned();
+
+ private:
+  friend class RegionScanner;
+  bool isOutdated(int generation);
+  void store(int generation, QHash<ChunkID, QImage> images);
+
+  QThreadPool            scanPool;    // own pool, clearing the ChunkCache does not wait for scans
+  QMutex                 mutex;
+  int                    generation;  // incremented for each path, outdated scans are dropped
+  QHash<ChunkID, QImage> regions;
+};
+
+#endif  // REGIONOVERVIEW_H_
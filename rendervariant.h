@@ -0,0 +1,117 @@
+/** Copyright (c) 2026, EtlamGit */
+#ifndef RENDERVARIANT_H_
+#define RENDERVARIANT_H_
+
+#include <QList>
+#include <cstring>
+
+#include "memorypool.h"
+
+
+// copy of the render base pass results of one Chunk
+class RenderVariant : public PooledObject<RenderVariant> {
+ public:
+  int    renderedAt;
+  int    baseFlags;  // render flags without overlay flags
+  uchar  baseImage[16 * 16 * 4];
+  short  depth[16 * 16];
+  uchar  baseShade[16 * 16];
+  uchar  baseCave[16 * 16];
+  uchar  baseSamples[16 * 16];
+  uchar  topLight[16 * 16];
+  qint16 topBiome[16 * 16];
+};
+
+
+// Most recent base pass results of one Chunk for different depth / flags,
+// newest first. Variants are keyed on the base pass flags only, overlay flags
+// are applied again to restored results.
+// Memory is accounted in a Budget (reserveRenderMemory / releaseRenderMemory).
+class RenderVariantList {
+ public:
+  static const int maxVariants = 4;
+
+  ~RenderVariantList() { qDeleteAll(variants); }
+
+  int size() const { return variants.size(); }
+
+  template <class ChunkT, class Budget>
+  void store(const ChunkT &chunk, int overlayFlags, Budget &budget);
+  template <class ChunkT>
+  bool restore(ChunkT &chunk, int depth, int flags, int overlayFlags);
+  template <class Budget>
+  void release(Budget &budget);
+
+ private:
+  QList<RenderVariant*> variants;
+};
+
+
+// keep current base pass results of chunk for later reuse
+template <class ChunkT, class Budget>
+void RenderVariantList::store(const ChunkT &chunk, int overlayFlags, Budget &budget) {
+  const int baseFlags = chunk.renderedFlags & ~overlayFlags;
+  RenderVariant *variant = nullptr;
+  // replace an existing variant with same key
+  for (int i = 0; i < variants.size(); i++) {
+    if ((variants[i]->renderedAt == chunk.renderedAt) &&
+        (variants[i]->baseFlags == baseFlags)) {
+      variant = variants.takeAt(i);
+      break;
+    }
+  }
+  // otherwise recycle the least recently used one, or allocate when budget allows
+  if (!variant && (variants.size() >= maxVariants))
+    variant = variants.takeLast();
+  if (!variant) {
+    if (!budget.reserveRenderMemory(sizeof(RenderVariant)))
+      return;
+    variant = new RenderVariant();
+  }
+
+  variant->renderedAt = chunk.renderedAt;
+  variant->baseFlags  = baseFlags;
+  memcpy(variant->baseImage,   chunk.baseImage,   sizeof(variant->baseImage));
+  memcpy(variant->depth,       chunk.depth,       sizeof(variant->depth));
+  memcpy(variant->baseShade,   chunk.baseShade,   sizeof(variant->baseShade));
+  memcpy(variant->baseCave,    chunk.baseCave,    sizeof(variant->baseCave));
+  memcpy(variant->baseSamples, chunk.baseSamples, sizeof(variant->baseSamples));
+  memcpy(variant->topLight,    chunk.topLight,    sizeof(variant->topLight));
+  memcpy(variant->topBiome,    chunk.topBiome,    sizeof(variant->topBiome));
+  variants.prepend(variant);
+}
+
+// reuse already rendered base pass results,
+// chunk gets only the base flags, so the caller has to apply overlays again
+template <class ChunkT>
+bool RenderVariantList::restore(ChunkT &chunk, int depth, int flags, int overlayFlags) {
+  const int baseFlags = flags & ~overlayFlags;
+  for (int i = 0; i < variants.size(); i++) {
+    RenderVariant *variant = variants[i];
+    if ((variant->renderedAt == depth) && (variant->baseFlags == baseFlags)) {
+      chunk.renderedAt    = variant->renderedAt;
+      chunk.renderedFlags = variant->baseFlags;
+      memcpy(chunk.baseImage,   variant->baseImage,   sizeof(variant->baseImage));
+      memcpy(chunk.depth,       variant->depth,       sizeof(variant->depth));
+      memcpy(chunk.baseShade,   variant->baseShade,   sizeof(variant->baseShade));
+      memcpy(chunk.baseCave,    variant->baseCave,    sizeof(variant->baseCave));
+      memcpy(chunk.baseSamples, variant->baseSamples, sizeof(variant->baseSamples));
+      memcpy(chunk.topLight,    variant->topLight,    sizeof(variant->topLight));
+      memcpy(chunk.topBiome,    variant->topBiome,    sizeof(variant->topBiome));
+      variants.move(i, 0);
+      return true;
+    }
+  }
+  return false;
+}
+
+template <class Budget>
+void RenderVariantList::release(Budget &budget) {
+  for (auto variant : variants) {
+    delete variant;
+    budget.releaseRenderMemory(sizeof(RenderVariant));
+  }
+  variants.clear();
+}
+
+#endif  // RENDERVARIANT_H_
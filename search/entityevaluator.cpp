@@ -157,7 +157,7 @@ void EntityEvaluator::addResult()
 {
   SearchResultItem result;
   result.properties = config.entity->properties();
-  result.name = creator.GetSummary("[0]", config.entity->properties());
+  result.name = creator.GetSummary("[0]", result.properties);
   result.pos.setX(config.entity->midpoint().x);
   result.pos.setY(config.entity->midpoint().y);
   result.pos.setZ(config.entity->midpoint().z);
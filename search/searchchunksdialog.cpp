@@ -126,7 +126,8 @@ void SearchChunksDialog::on_resultList_updateSearchResultPositions(QVector<QShar
 
 void SearchChunksDialog::AsyncSearch::loadChunk_async(ChunkID id)
 {
-  QSharedPointer<Chunk> chunk = ChunkCache::Instance().getChunkSynchronously(id);
+  // search plugins may look at Entities, even when they are not shown
+  QSharedPointer<Chunk> chunk = ChunkCache::Instance().getChunkSynchronously(id, true);
 
   QSharedPointer<SearchPluginI::ResultListT> results;
 
@@ -274,7 +274,7 @@ StatisticResultMap StatisticDialog::AsyncStatistic::processChunk_async(const Chu
 {
   StatisticResultMap results;
 
-  QSharedPointer<Chunk> chunk = ChunkCache::Instance().getChunkSynchronously(id);
+  QSharedPointer<Chunk> chunk = ChunkCache::Instance().getChunkSynchronously(id, false);  // Blocks only
   if (chunk) {
     for (auto y = range_y.begin(); y <= range_y.end(); y++) {
       StatisticResultItem ri; // init to empty Chunk layer
@@ -0,0 +1,140 @@
+/** Copyright (c) 2026, EtlamGit */
+
+#include <QtTest>
+#include <QVector>
+
+#include "columnblend.h"
+
+// translucent alpha values used in the Block definitions
+static const double definitionAlphas[] = {0.25, 0.28, 0.3, 0.4, 0.5, 0.53, 0.6, 0.62, 0.63,
+                                          0.7, 0.75, 0.8, 0.9, 0.95, 1.0};
+
+// Compares the fixed point ColumnBlend with the floating point blending
+// ChunkRenderer used before, on columns built from Block definition alphas.
+class TestColumnBlend : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void opaqueStops();
+  void thresholdMatches();
+  void goldenColumns();
+
+ private:
+  struct Sample {
+    quint8 r, g, b;
+    quint8 shade;
+    double alpha;
+  };
+  struct Result {
+    int    used;  // number of Blocks blended until saturated
+    quint8 r, g, b;
+    double shade;
+  };
+
+  static Result blendFloat(const QVector<Sample> &column);
+  static Result blendFixed(const QVector<Sample> &column);
+  static void   compare(const QVector<Sample> &column);
+};
+
+
+// reference: floating point blending of the former ChunkRenderer
+TestColumnBlend::Result TestColumnBlend::blendFloat(const QVector<Sample> &column) {
+  Result result = {0, 0, 0, 0, 0.0};
+  double alpha = 0.0;
+  for (const Sample &s : column) {
+    result.used++;
+    if (alpha == 0.0) {
+      alpha = s.alpha;
+      result.r = s.r;
+      result.g = s.g;
+      result.b = s.b;
+      result.shade = s.shade;
+    } else {
+      result.r = (quint8)(alpha * result.r + (1.0 - alpha) * s.r);
+      result.g = (quint8)(alpha * result.g + (1.0 - alpha) * s.g);
+      result.b = (quint8)(alpha * result.b + (1.0 - alpha) * s.b);
+      result.shade = alpha * result.shade + (1.0 - alpha) * s.shade;
+      alpha += s.alpha * (1.0 - alpha);
+    }
+    if (s.alpha == 1.0 || alpha > 0.9)
+      break;
+  }
+  return result;
+}
+
+TestColumnBlend::Result TestColumnBlend::blendFixed(const QVector<Sample> &column) {
+  Result result = {0, 0, 0, 0, 0.0};
+  ColumnBlend blend;
+  for (const Sample &s : column) {
+    result.used++;
+    if (blend.add(s.r, s.g, s.b, s.shade, ColumnBlend::toFixed(s.alpha)))
+      break;
+  }
+  result.r = blend.r;
+  result.g = blend.g;
+  result.b = blend.b;
+  result.shade = blend.shade();
+  return result;
+}
+
+void TestColumnBlend::compare(const QVector<Sample> &column) {
+  Result expected = blendFloat(column);
+  Result actual   = blendFixed(column);
+  QCOMPARE(actual.used, expected.used);
+  QVERIFY(qAbs(actual.r - expected.r) <= 1);
+  QVERIFY(qAbs(actual.g - expected.g) <= 1);
+  QVERIFY(qAbs(actual.b - expected.b) <= 1);
+  QVERIFY(qAbs(actual.shade - expected.shade) <= 1.0);
+}
+
+
+void TestColumnBlend::opaqueStops() {
+  QVector<Sample> column;
+  column << Sample{200, 100, 50, 0, 1.0} << Sample{10, 20, 30, 0, 1.0};
+  Result result = blendFixed(column);
+  QCOMPARE(result.used, 1);
+  QCOMPARE(int(result.r), 200);
+  QCOMPARE(int(result.g), 100);
+  QCOMPARE(int(result.b), 50);
+}
+
+// all stacks of up to 5 Block definition alphas end at the same Block
+void TestColumnBlend::thresholdMatches() {
+  const int numAlphas = sizeof(definitionAlphas) / sizeof(*definitionAlphas);
+  for (int length = 1; length <= 5; length++) {
+    int combinations = 1;
+    for (int i = 0; i < length; i++)
+      combinations *= numAlphas;
+    for (int c = 0; c < combinations; c++) {
+      QVector<Sample> column;
+      for (int i = 0, rest = c; i < length; i++, rest /= numAlphas)
+        column << Sample{quint8(40 * i), 128, quint8(255 - 40 * i), quint8(6 * i), definitionAlphas[rest % numAlphas]};
+      compare(column);
+    }
+  }
+}
+
+// 16 images of 16x16 columns with translucent stacks from the Block definitions
+void TestColumnBlend::goldenColumns() {
+  const int numAlphas = sizeof(definitionAlphas) / sizeof(*definitionAlphas);
+  quint32 seed = 0x12345678;
+  auto random = [&seed](int range) {
+    seed = seed * 1664525u + 1013904223u;  // fixed sequence, results are reproducible
+    return int((seed >> 8) % quint32(range));
+  };
+
+  for (int image = 0; image < 16; image++) {
+    for (int offset = 0; offset < 16 * 16; offset++) {
+      QVector<Sample> column;
+      const int height = 1 + random(24);
+      for (int i = 0; i < height; i++) {
+        column << Sample{quint8(random(256)), quint8(random(256)), quint8(random(256)),
+                         quint8(random(33)), definitionAlphas[random(numAlphas)]};
+      }
+      compare(column);
+    }
+  }
+}
+
+QTEST_APPLESS_MAIN(TestColumnBlend)
+#include "tst_columnblend.moc"
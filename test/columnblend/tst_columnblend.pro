@@ -0,0 +1,12 @@
+QT += testlib
+QT -= gui
+CONFIG += testcase console c++14
+CONFIG -= app_bundle
+TARGET = tst_columnblend
+
+INCLUDEPATH += ../..
+
+HEADERS += \
+    ../../columnblend.h
+SOURCES += \
+    tst_columnblend.cpp
@@ -0,0 +1,133 @@
+/** Copyright (c) 2026, EtlamGit */
+
+#include <QtTest>
+
+#include "rendervariant.h"
+
+// same values as MapView / ChunkRenderer
+static const int flgLighting      = 1 << 0;
+static const int flgCaveMode      = 1 << 2;
+static const int flgDepthShading  = 1 << 3;
+static const int flgBiomeColors   = 1 << 4;
+static const int flgSlimeChunks   = 1 << 7;
+static const int flgInhabitedTime = 1 << 8;
+static const int overlayFlags = flgDepthShading | flgSlimeChunks | flgInhabitedTime | flgBiomeColors;
+
+// stores and restores base pass results like Chunk does,
+// overlay flags must not be part of the key
+class TestRenderVariant : public QObject {
+  Q_OBJECT
+
+ private slots:
+  void restoreWithDepthShading();
+  void overlayFlagsShareVariant();
+  void baseFlagsDiffer();
+  void budgetExhausted();
+
+ private:
+  // the parts of a Chunk used by RenderVariantList
+  struct FakeChunk {
+    int    renderedAt;
+    int    renderedFlags;
+    uchar  baseImage[16 * 16 * 4];
+    short  depth[16 * 16];
+    uchar  baseShade[16 * 16];
+    uchar  baseCave[16 * 16];
+    uchar  baseSamples[16 * 16];
+    uchar  topLight[16 * 16];
+    qint16 topBiome[16 * 16];
+
+    void fill(int renderedAt, int renderedFlags, uchar value) {
+      this->renderedAt    = renderedAt;
+      this->renderedFlags = renderedFlags;
+      memset(baseImage,   value, sizeof(baseImage));
+      memset(depth,       value, sizeof(depth));
+      memset(baseShade,   value, sizeof(baseShade));
+      memset(baseCave,    value, sizeof(baseCave));
+      memset(baseSamples, value, sizeof(baseSamples));
+      memset(topLight,    value, sizeof(topLight));
+      memset(topBiome,    value, sizeof(topBiome));
+    }
+  };
+
+  struct Budget {
+    qint64 used  = 0;
+    qint64 limit = 1 << 30;
+    bool reserveRenderMemory(int bytes) {
+      if (used + bytes > limit) return false;
+      used += bytes;
+      return true;
+    }
+    void releaseRenderMemory(int bytes) { used -= bytes; }
+  };
+};
+
+
+void TestRenderVariant::restoreWithDepthShading() {
+  Budget budget;
+  RenderVariantList list;
+  FakeChunk chunk;
+  // ChunkRenderer::renderOverlays() leaves all flags in renderedFlags
+  chunk.fill(64, flgLighting | flgDepthShading, 0x11);
+  list.store(chunk, overlayFlags, budget);
+  chunk.fill(80, flgLighting | flgDepthShading, 0x22);
+  list.store(chunk, overlayFlags, budget);
+  QCOMPARE(list.size(), 2);
+
+  // back to the first depth with depth shading still on
+  QVERIFY(list.restore(chunk, 64, flgLighting | flgDepthShading, overlayFlags));
+  QCOMPARE(chunk.renderedAt, 64);
+  // only base flags are restored, so overlays are applied again
+  QCOMPARE(chunk.renderedFlags, flgLighting);
+  QCOMPARE(int(chunk.baseImage[0]), 0x11);
+  QCOMPARE(int(chunk.topLight[255]), 0x11);
+
+  list.release(budget);
+  QCOMPARE(budget.used, qint64(0));
+}
+
+void TestRenderVariant::overlayFlagsShareVariant() {
+  Budget budget;
+  RenderVariantList list;
+  FakeChunk chunk;
+  chunk.fill(64, flgLighting | flgSlimeChunks, 0x11);
+  list.store(chunk, overlayFlags, budget);
+  // same base pass with other overlays replaces the variant
+  chunk.fill(64, flgLighting | flgInhabitedTime, 0x22);
+  list.store(chunk, overlayFlags, budget);
+  QCOMPARE(list.size(), 1);
+
+  QVERIFY(list.restore(chunk, 64, flgLighting | flgBiomeColors, overlayFlags));
+  QCOMPARE(int(chunk.baseShade[0]), 0x22);
+  list.release(budget);
+}
+
+void TestRenderVariant::baseFlagsDiffer() {
+  Budget budget;
+  RenderVariantList list;
+  FakeChunk chunk;
+  chunk.fill(64, flgLighting | flgDepthShading, 0x11);
+  list.store(chunk, overlayFlags, budget);
+  QVERIFY(!list.restore(chunk, 64, flgCaveMode | flgDepthShading, overlayFlags));
+  QVERIFY(!list.restore(chunk, 63, flgLighting | flgDepthShading, overlayFlags));
+  list.release(budget);
+}
+
+void TestRenderVariant::budgetExhausted() {
+  Budget budget;
+  budget.limit = sizeof(RenderVariant);
+  RenderVariantList list;
+  FakeChunk chunk;
+  chunk.fill(64, 0, 0x11);
+  list.store(chunk, overlayFlags, budget);
+  chunk.fill(65, 0, 0x22);
+  list.store(chunk, overlayFlags, budget);
+  QCOMPARE(list.size(), 1);
+  QVERIFY(list.restore(chunk, 64, 0, overlayFlags));
+  QVERIFY(!list.restore(chunk, 65, 0, overlayFlags));
+  list.release(budget);
+  QCOMPARE(budget.used, qint64(0));
+}
+
+QTEST_APPLESS_MAIN(TestRenderVariant)
+#include "tst_rendervariant.moc"
@@ -0,0 +1,14 @@
+QT += testlib
+QT -= gui
+CONFIG += testcase console c++14
+CONFIG -= app_bundle
+TARGET = tst_rendervariant
+
+INCLUDEPATH += ../..
+
+HEADERS += \
+    ../../memorypool.h \
+    ../../rendervariant.h
+SOURCES += \
+    ../../memorypool.cpp \
+    tst_rendervariant.cpp
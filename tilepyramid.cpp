@@ -0,0 +1,291 @@
+/** Copyright (c) 2026, EtlamGit */
+
+#include <algorithm>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QStandardPaths>
+
+#include "tilepyramid.h"
+#include "blitter.h"
+#include "chunk.h"
+#include "chunkloader.h"
+#include "chunkrenderer.h"
+
+
+// renders all Chunks of one Region and reduces them to the Tiles of all levels
+class TileBuilder : public QRunnable {
+ public:
+  TileBuilder(int rx, int rz, int depth, int flags, int generation, QString path, QString tileFile)
+    : rx(rx), rz(rz), depth(depth), flags(flags), generation(generation)
+    , path(path), tileFile(tileFile) {}
+
+ protected:
+  void run();
+
+ private:
+  bool outdated() const;
+
+  int rx, rz;
+  int depth;
+  int flags;
+  int generation;
+  QString path;
+  QString tileFile;
+};
+
+
+bool TileBuilder::outdated() const {
+  return TilePyramid::Instance().generation.loadAcquire() != generation;
+}
+
+void TileBuilder::run() {
+  // skip Regions scrolled out of view while queued
+  if (!TilePyramid::Instance().startBuilding(generation, rx, rz)) return;
+
+  // Tile cache on disk is valid as long as the Region file was not modified
+  QImage base;
+  QFileInfo tileInfo(tileFile);
+  QString regionFile = path + "/region/r." + QString::number(rx) + "." + QString::number(rz) + ".mca";
+  if (tileInfo.exists() &&
+      tileInfo.lastModified() >= QFileInfo(regionFile).lastModified()) {
+    base.load(tileFile);
+    if (base.size() != QSize(512 >> TilePyramid::LOD_MIN, 512 >> TilePyramid::LOD_MIN))
+      base = QImage();
+    else
+      base = base.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+  }
+
+  if (base.isNull()) {
+    // Region file is opened and mapped once for all its Chunks (unmapped with file)
+    QFile file(regionFile);
+    const uchar *mapped = nullptr;
+    qint64 size = 0;
+    if (file.open(QIODevice::ReadOnly)) {
+      size   = file.size();
+      mapped = file.map(0, size);
+    }
+
+    QImage region(32 * 16, 32 * 16, QImage::Format_ARGB32_Premultiplied);
+    region.fill(Qt::transparent);
+
+    for (int cz = 0; cz < 32; cz++)
+      for (int cx = 0; cx < 32; cx++) {
+        if (outdated()) return;
+        // private temporary Chunk, cached ones may be rendered by MapView at the same time
+        QSharedPointer<Chunk> chunk(new Chunk());
+        if (!mapped || !ChunkLoader::loadNbtMapped(mapped, size, rx * 32 + cx, rz * 32 + cz, chunk) || !chunk->loaded)
+          continue;
+
+        ChunkRenderer(chunk->getChunkX(), chunk->getChunkZ(), depth, flags).renderChunk(chunk);
+        const quint32 *src = reinterpret_cast<const quint32 *>(chunk->getImage());
+        for (int z = 0; z < 16; z++) {
+          quint32 *dst = reinterpret_cast<quint32 *>(region.scanLine(cz * 16 + z)) + cx * 16;
+          for (int x = 0; x < 16; x++)
+            dst[x] = src[z * 16 + x] | 0xff000000;  // rendered Chunks are opaque
+        }
+      }
+
+    base = region;
+    for (int level = 0; level < TilePyramid::LOD_MIN; level++)
+      base = Blitter::halve(base);
+
+    QDir().mkpath(tileInfo.absolutePath());
+    if (base.save(tileFile, "PNG"))
+      TilePyramid::Instance().tileWritten(QFileInfo(tileFile).size());
+  }
+
+  TilePyramid::Instance().storeTiles(generation, rx, rz, base);
+}
+
+
+uint qHash(const TilePyramid::TileID &id, uint seed) {
+  return qHash((id.rx << 16) ^ (id.rz & 0xffff), seed) ^ id.level;
+}
+
+TilePyramid::TilePyramid()
+  : depth(0)
+  , flags(0)
+  , generation(0)
+  , diskWritten(DISK_PRUNE_STEP)  // check size with first written Tile
+  , pruning(0)
+{
+  // Tiles of all visible Regions should fit, even on big screens
+  tiles.setMaxCost(256 * 1024 * 1024);
+
+  // building is mostly disk access and decoding, leave room for the ChunkCache
+  builderPool.setMaxThreadCount(std::max(1, builderPool.maxThreadCount() / 2));
+}
+
+TilePyramid::~TilePyramid() {
+  generation.fetchAndAddOrdered(1);
+  builderPool.clear();
+  builderPool.waitForDone();
+}
+
+TilePyramid &TilePyramid::Instance() {
+  static TilePyramid singleton;
+  return singleton;
+}
+
+void TilePyramid::setPath(QString path) {
+  QMutexLocker guard(&mutex);
+  if (this->path == path) return;
+  this->path = path;
+  guard.unlock();
+
+  clear();
+  scanRegions();
+}
+
+void TilePyramid::setView(int depth, int flags) {
+  QMutexLocker guard(&mutex);
+  if ((this->depth == depth) && (this->flags == flags)) return;
+  this->depth = depth;
+  this->flags = flags;
+  guard.unlock();
+
+  clear();
+}
+
+void TilePyramid::clear(bool purgeDisk) {
+  generation.fetchAndAddOrdered(1);
+  builderPool.clear();
+
+  // running builders stop with the next Chunk, wait for them before purging
+  if (purgeDisk)
+    builderPool.waitForDone();
+
+  QMutexLocker guard(&mutex);
+  tiles.clear();
+  building.clear();
+  if (purgeDisk && !path.isEmpty()) {
+    QDir(tileDirectory()).removeRecursively();
+  }
+}
+
+void TilePyramid::cancelBuilding() {
+  QMutexLocker guard(&mutex);
+  if (building.isEmpty()) return;
+  // running builders stop with the next Chunk, finished Tiles stay in memory
+  generation.fetchAndAddOrdered(1);
+  builderPool.clear();
+  building.clear();
+}
+
+void TilePyramid::setVisibleRegions(QRect area) {
+  QMutexLocker guard(&mutex);
+  visible = area;
+}
+
+bool TilePyramid::startBuilding(int generation, int rx, int rz) {
+  QMutexLocker guard(&mutex);
+  if (this->generation.loadAcquire() != generation) return false;
+  if (visible.contains(rx, rz)) return true;
+  // built again with the next getTile() when visible
+  building.remove(ChunkID(rx, rz));
+  return false;
+}
+
+void TilePyramid::tileWritten(qint64 bytes) {
+  if (diskWritten.fetchAndAddRelaxed(bytes) + bytes < DISK_PRUNE_STEP)
+    return;
+  if (!pruning.testAndSetAcquire(0, 1))
+    return;  // another builder is pruning
+  diskWritten.storeRelease(0);
+  pruneDiskCache(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/tiles", DISK_CACHE_MAX);
+  pruning.storeRelease(0);
+}
+
+// removes the oldest Tiles when the cache directory exceeds maxSize
+void TilePyramid::pruneDiskCache(QString directory, qint64 maxSize) {
+  QFileInfoList files;
+  qint64 total = 0;
+  QDirIterator it(directory, QStringList() << "*.png", QDir::Files, QDirIterator::Subdirectories);
+  while (it.hasNext()) {
+    it.next();
+    files.append(it.fileInfo());
+    total += it.fileInfo().size();
+  }
+  if (total <= maxSize) return;
+
+  std::sort(files.begin(), files.end(), [](const QFileInfo &a, const QFileInfo &b) {
+    return a.lastModified() < b.lastModified();
+  });
+  // make some room, to not prune again with the next Tile
+  const qint64 target = maxSize / 4 * 3;
+  for (const QFileInfo &file : files) {
+    if (total <= target) break;
+    if (QFile::remove(file.absoluteFilePath()))
+      total -= file.size();
+    QDir().rmdir(file.absolutePath());  // only succeeds when empty
+  }
+}
+
+void TilePyramid::scanRegions() {
+  QSet<ChunkID> found;
+  QRegularExpression pattern("^r\\.(-?\\d+)\\.(-?\\d+)\\.mca$");
+  QDir dir(path + "/region");
+  for (const QString &name : dir.entryList(QStringList() << "r.*.*.mca", QDir::Files)) {
+    QRegularExpressionMatch match = pattern.match(name);
+    if (match.hasMatch())
+      found.insert(ChunkID(match.captured(1).toInt(), match.captured(2).toInt()));
+  }
+
+  QMutexLocker guard(&mutex);
+  regions = found;
+}
+
+// one directory per world: <cache>/tiles/<hash of path>/, with sub directories per view
+QString TilePyramid::tileDirectory() const {
+  QString hash = QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Md5).toHex();
+  return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/tiles/" + hash;
+}
+
+bool TilePyramid::hasRegion(int rx, int rz) {
+  QMutexLocker guard(&mutex);
+  return regions.contains(ChunkID(rx, rz));
+}
+
+QImage TilePyramid::getTile(int level, int rx, int rz) {
+  QMutexLocker guard(&mutex);
+  ChunkID region(rx, rz);
+  if (!regions.contains(region))
+    return QImage();
+
+  QImage *tile = tiles.object(TileID{level, rx, rz});
+  if (tile)
+    return *tile;
+
+  if (!building.contains(region)) {
+    building.insert(region);
+    QString suffix = QString::number(rx) + "." + QString::number(rz);
+    // Regions near the center of the view are built first
+    QPoint distance = QPoint(rx, rz) - visible.center();
+    builderPool.start(new TileBuilder(rx, rz, depth, flags, generation.loadAcquire(), path,
+                                      tileDirectory() + "/" + QString::number(depth) + "_" +
+                                      QString::number(flags) + "/r." + suffix + ".png"),
+                      -distance.manhattanLength());
+  }
+  return QImage();
+}
+
+void TilePyramid::storeTiles(int generation, int rx, int rz, QImage base) {
+  {
+    QMutexLocker guard(&mutex);
+    if (this->generation.loadAcquire() != generation) return;
+    building.remove(ChunkID(rx, rz));
+
+    QImage tile = base;
+    for (int level = LOD_MIN; level <= LOD_MAX; level++) {
+      tiles.insert(TileID{level, rx, rz}, new QImage(tile), tile.bytesPerLine() * tile.height());
+      if (level < LOD_MAX)
+        tile = Blitter::halve(tile);
+    }
+  }
+  emit tileReady(rx, rz);
+}
@@ -0,0 +1,84 @@
+/** Copyright (c) 2026, EtlamGit */
+#ifndef TILEPYRAMID_H_
+#define TILEPYRAMID_H_
+
+#include <QObject>
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QRect>
+#include <QSet>
+#include <QThreadPool>
+#include "chunkid.h"
+
+// Level of detail pyramid for zoomed out views.
+// Every Region (32x32 Chunks) is stored as one Tile per level, a Tile of
+// level L has one pixel for 2^L x 2^L Blocks. Tiles are built in background
+// from rendered Chunks, kept in memory and in a Tile cache on disk,
+// so zoomed out views are drawn without touching any Chunk data.
+class TilePyramid : public QObject {
+  Q_OBJECT
+
+ public:
+  // singleton: access to global usable instance
+  static TilePyramid &Instance();
+ private:
+  // singleton: prevent access to constructor and copyconstructor
+  TilePyramid();
+  ~TilePyramid();
+  TilePyramid(const TilePyramid &);
+  TilePyramid &operator=(const TilePyramid &);
+
+ public:
+  static const int LOD_MIN = 2;  //  4 x  4 Blocks per pixel
+  static const int LOD_MAX = 6;  // 64 x 64 Blocks per pixel
+
+  static const qint64 DISK_CACHE_MAX  = 512 * 1024 * 1024;  // Tile cache on disk (all worlds)
+  static const qint64 DISK_PRUNE_STEP = DISK_CACHE_MAX / 8;  // written bytes between size checks
+
+  void setPath(QString path);           // switch world / dimension
+  void setView(int depth, int flags);   // Tiles are only valid for one view
+  void clear(bool purgeDisk = false);
+  void cancelBuilding();                // Tiles are not needed any longer (zoomed in)
+  void setVisibleRegions(QRect area);   // queued Tiles outside are dropped
+
+  bool hasRegion(int rx, int rz);
+  // get Tile, starts building it when not available (and returns a null image)
+  QImage getTile(int level, int rx, int rz);
+
+ signals:
+  void tileReady(int rx, int rz);
+
+ private:
+  friend class TileBuilder;
+
+  struct TileID {
+    int level, rx, rz;
+    bool operator==(const TileID &other) const {
+      return (level == other.level) && (rx == other.rx) && (rz == other.rz);
+    }
+  };
+  friend uint qHash(const TileID &id, uint seed);
+
+  void    scanRegions();
+  QString tileDirectory() const;
+  bool    startBuilding(int generation, int rx, int rz);  // false when no longer needed
+  void    storeTiles(int generation, int rx, int rz, QImage base);
+  void    tileWritten(qint64 bytes);   // prunes the disk cache from time to time
+  static void pruneDiskCache(QString directory, qint64 maxSize);
+
+  QMutex              mutex;
+  QString             path;
+  int                 depth;
+  int                 flags;
+  QAtomicInt          generation;   // incremented on clear, outdated builders are dropped
+  QAtomicInteger<qint64> diskWritten;  // bytes written since last pruning
+  QAtomicInt          pruning;      // disk cache is pruned by one builder at a time
+  QSet<ChunkID>       regions;      // existing Region files
+  QSet<ChunkID>       building;     // Regions queued for building
+  QRect               visible;      // Regions currently shown by MapView
+  QCache<TileID, QImage> tiles;     // cost is size in bytes
+  QThreadPool         builderPool;  // extra thread pool for building Tiles
+};
+
+#endif  // TILEPYRAMID_H_
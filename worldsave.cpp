@@ -8,6 +8,7 @@
  */
 
 #include <zlib.h>
+#include <QThreadPool>
 #include "worldsave.h"
 #include "mapview.h"
 #include "chunkloader.h"
@@ -23,9 +24,25 @@ WorldSave::WorldSave(QString filename, MapView *map,
   bottom(bottom),
   right(right),
   regionChecker(regionChecker),
-  chunkChecker(chunkChecker) {
+  chunkChecker(chunkChecker),
+  renderDepth(0),
+  renderFlags(0) {
 }
 
+// renders one row of Chunks into the reorder buffer of WorldSave
+class RowRenderer : public QRunnable {
+ public:
+  RowRenderer(WorldSave *save, QString path, int cz) : save(save), path(path), cz(cz) {}
+
+ protected:
+  void run() { save->renderRow(path, cz); }
+
+ private:
+  WorldSave *save;
+  QString path;
+  int cz;
+};
+
 WorldSave::~WorldSave() {
 }
 
@@ -91,10 +108,6 @@ void WorldSave::run() {
   int insize = width * 16 * 4 + 16;
   int outsize = insize * 2;
 
-  uchar *scanlines = new uchar[insize];
-  for (int i = 0; i < 16; i++)  // set scanline filters to off
-    scanlines[i * (width * 4 + 1)] = 0;
-
   uchar *compressed = new uchar[outsize];
   z_stream strm;
   strm.zalloc = Z_NULL;
@@ -102,24 +115,35 @@ void WorldSave::run() {
   strm.opaque = Z_NULL;
   deflateInit2(&strm, 6, Z_DEFLATED, 15, 8, Z_DEFAULT_STRATEGY);
 
-  double maximum = (bottom + 1 - top) * (right + 1 - left);
-  double step = 0.0;
+  // rows of Chunks are rendered in parallel, but written in order
+  renderDepth = map->getDepth();
+  renderFlags = map->getFlags();
+  rowsDone.clear();
+  QThreadPool pool;
+  // bounded number of rows in flight (rendering or waiting to be written)
+  const qint64 memoryLimit = 256 * 1024 * 1024;
+  const int window = std::max<qint64>(2, std::min<qint64>(2 * pool.maxThreadCount(), memoryLimit / insize));
+
+  double maximum = (bottom + 1 - top);
+  int next = top;  // next row to render
   for (int cz = top; cz <= bottom; cz++) {
-    for (int cx = left; cx <= right; cx++, step += 1.0) {
-      emit progress(tr("Rendering world"), step / maximum);
-
-      // create a temporary Chunk for PNG processing
-      QSharedPointer<Chunk> chunk(new Chunk());
-
-      if (ChunkLoader::loadNbt(path, cx, cz, chunk)) {
-        drawChunk(scanlines, width * 4 + 1, cx - left, chunk);
-      } else {
-        blankChunk(scanlines, width * 4 + 1, cx - left);
-      }
+    while ((next <= bottom) && (next - cz < window))
+      pool.start(new RowRenderer(this, path, next++));
+
+    emit progress(tr("Rendering world"), (cz - top) / maximum);
+
+    // wait for the row to be written next
+    QByteArray scanlines;
+    {
+      QMutexLocker guard(&rowMutex);
+      while (!rowsDone.contains(cz))
+        rowReady.wait(&rowMutex);
+      scanlines = rowsDone.take(cz);
     }
+
     // write out scanlines to disk
     strm.avail_in = insize;
-    strm.next_in = scanlines;
+    strm.next_in = reinterpret_cast<uchar *>(scanlines.data());
     do {
       strm.avail_out = outsize;
       strm.next_out = compressed;
@@ -128,7 +152,6 @@ void WorldSave::run() {
     } while (strm.avail_out == 0);
   }
   deflateEnd(&strm);
-  delete [] scanlines;
   delete [] compressed;
 
   writeChunk(&png, "IEND", NULL, 0);
@@ -256,6 +279,29 @@ void WorldSave::findWorldBounds(QString path,
   *right  = (edges[3].front().x * 32) + maxx;
 }
 
+void WorldSave::renderRow(QString path, int cz) {
+  int width  = (right + 1 - left) * 16;
+  int stride = width * 4 + 1;
+  // zero initialized: scanline filters are off
+  QByteArray row(stride * 16, 0);
+  uchar *scanlines = reinterpret_cast<uchar *>(row.data());
+
+  for (int cx = left; cx <= right; cx++) {
+    // create a temporary Chunk for PNG processing (Entities are not drawn)
+    QSharedPointer<Chunk> chunk(new Chunk());
+
+    if (ChunkLoader::loadNbt(path, cx, cz, chunk, false)) {
+      drawChunk(scanlines, stride, cx - left, chunk);
+    } else {
+      blankChunk(scanlines, stride, cx - left);
+    }
+  }
+
+  QMutexLocker guard(&rowMutex);
+  rowsDone.insert(cz, row);
+  rowReady.wakeAll();
+}
+
 // sets chunk to transparent
 void WorldSave::blankChunk(uchar *scanlines, int stride, int x) {
   int offset = x * 16 * 4 + 1;
@@ -273,7 +319,7 @@ void WorldSave::drawChunk(uchar *scanlines, int stride, int x, QSharedPointer<Ch
     attenuation *= 0.9f;
 
   // render chunk with current settings
-  ChunkRenderer renderer(chunk->getChunkX(), chunk->getChunkZ(), map->getDepth(), map->getFlags());
+  ChunkRenderer renderer(chunk->getChunkX(), chunk->getChunkZ(), renderDepth, renderFlags);
   renderer.renderChunk(chunk);
   // we can't memcpy each scanline because it's in BGRA format.
   int offset = x * 16 * 4 + 1;
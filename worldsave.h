@@ -2,8 +2,11 @@
 #ifndef WORLDSAVE_H_
 #define WORLDSAVE_H_
 
+#include <QMap>
+#include <QMutex>
 #include <QObject>
 #include <QRunnable>
+#include <QWaitCondition>
 
 class MapView;
 class Chunk;
@@ -24,6 +27,8 @@ class WorldSave : public QObject, public QRunnable {
   void run();
 
  private:
+  friend class RowRenderer;
+  void renderRow(QString path, int cz);  // called from worker threads
   void blankChunk(uchar *scanlines, int stride, int x);
   void drawChunk(uchar *scanlines, int stride, int x, QSharedPointer<Chunk> chunk);
 
@@ -35,6 +40,13 @@ class WorldSave : public QObject, public QRunnable {
   int right;
   bool regionChecker;
   bool chunkChecker;
+  int renderDepth;   // view settings at start of export
+  int renderFlags;
+
+  // reorder buffer: rendered rows of Chunks waiting to be written in order
+  QMap<int, QByteArray> rowsDone;
+  QMutex rowMutex;
+  QWaitCondition rowReady;
 
  public: // static
   static void findWorldBounds(QString path, int *top, int *left, int *bottom, int *right);